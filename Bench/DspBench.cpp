@@ -0,0 +1,463 @@
+#include <JuceHeader.h>
+#include "../Source/VibratoEngine.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+//==============================================================================
+// Offline DSP benchmark: CPU cost per interpolation tier and ensemble size,
+// interpolation fidelity (THD+N) of each read kernel, the grain pitch engine
+// against the delay engine, shared against per-instance DSP tables, and
+// chunked parallel rendering against a serial render.
+//==============================================================================
+
+//==============================================================================
+// Heap accounting: live bytes handed out by operator new, aligned forms
+// included. Each block carries its size and malloc base in front of it, so
+// every delete form can account for it. Engines and tables allocate only
+// through new; JUCE's malloc-based containers are not seen.
+namespace
+{
+    std::atomic<juce::int64> liveHeapBytes { 0 };
+
+    void* countedAlloc (std::size_t size, std::size_t align)
+    {
+        align = juce::jmax (align, alignof (std::max_align_t));
+        auto* base = static_cast<char*> (std::malloc (size + align + 2 * sizeof (std::size_t)));
+        if (base == nullptr)
+            throw std::bad_alloc();
+
+        const auto start = reinterpret_cast<std::uintptr_t> (base + 2 * sizeof (std::size_t));
+        auto* p = reinterpret_cast<std::size_t*> ((start + align - 1) & ~(static_cast<std::uintptr_t> (align) - 1));
+        p[-1] = size;
+        p[-2] = reinterpret_cast<std::uintptr_t> (base);
+
+        liveHeapBytes.fetch_add (static_cast<juce::int64> (size), std::memory_order_relaxed);
+        return p;
+    }
+
+    void countedFree (void* ptr) noexcept
+    {
+        if (ptr == nullptr)
+            return;
+
+        auto* p = static_cast<std::size_t*> (ptr);
+        liveHeapBytes.fetch_sub (static_cast<juce::int64> (p[-1]), std::memory_order_relaxed);
+        std::free (reinterpret_cast<void*> (p[-2]));
+    }
+}
+
+void* operator new   (std::size_t size)                       { return countedAlloc (size, 0); }
+void* operator new[] (std::size_t size)                       { return countedAlloc (size, 0); }
+void* operator new   (std::size_t size, std::align_val_t a)   { return countedAlloc (size, static_cast<std::size_t> (a)); }
+void* operator new[] (std::size_t size, std::align_val_t a)   { return countedAlloc (size, static_cast<std::size_t> (a)); }
+
+void* operator new   (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return countedAlloc (size, 0); } catch (...) { return nullptr; }
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return countedAlloc (size, 0); } catch (...) { return nullptr; }
+}
+
+void operator delete   (void* p) noexcept                                     { countedFree (p); }
+void operator delete[] (void* p) noexcept                                     { countedFree (p); }
+void operator delete   (void* p, std::size_t) noexcept                        { countedFree (p); }
+void operator delete[] (void* p, std::size_t) noexcept                        { countedFree (p); }
+void operator delete   (void* p, std::align_val_t) noexcept                   { countedFree (p); }
+void operator delete[] (void* p, std::align_val_t) noexcept                   { countedFree (p); }
+void operator delete   (void* p, std::size_t, std::align_val_t) noexcept      { countedFree (p); }
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept      { countedFree (p); }
+void operator delete   (void* p, const std::nothrow_t&) noexcept              { countedFree (p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept              { countedFree (p); }
+
+//==============================================================================
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int    blockSize  = 512;
+
+    const char* qualityName (DelayInterpolation::Quality q)
+    {
+        switch (q)
+        {
+            case DelayInterpolation::Quality::Linear:   return "linear";
+            case DelayInterpolation::Quality::Hermite:  return "hermite";
+            case DelayInterpolation::Quality::Lagrange: return "lagrange6";
+            case DelayInterpolation::Quality::Sinc:     return "sinc16";
+        }
+        return "?";
+    }
+
+    //==========================================================================
+    // Nanoseconds per stereo sample for a fully engaged engine
+    double timeEngine (const VibratoEngine::Params& params, double seconds = 4.0)
+    {
+        auto engine = std::make_unique<VibratoEngine>();
+        engine->prepare (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        const int numBlocks = static_cast<int> (seconds * sampleRate) / blockSize;
+
+        double phase = 0.0;
+        auto fill = [&]
+        {
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const float s = static_cast<float> (0.5 * std::sin (phase));
+                phase += juce::MathConstants<double>::twoPi * 220.0 / sampleRate;
+                buffer.setSample (0, i, s);
+                buffer.setSample (1, i, s);
+            }
+        };
+
+        // Warm-up so the envelope is fully open
+        for (int b = 0; b < numBlocks / 4; ++b) { fill(); engine->process (buffer, params); }
+
+        double elapsed = 0.0;
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            fill();
+            const auto t0 = std::chrono::steady_clock::now();
+            engine->process (buffer, params);
+            elapsed += std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+        }
+
+        return elapsed * 1.0e9 / (static_cast<double> (numBlocks) * blockSize);
+    }
+
+    //==========================================================================
+    // Reads a sine at random fractional positions and compares against the
+    // exact value. Returns error-to-signal power in dB.
+    double measureThdN (DelayInterpolation::Quality q, double freqHz,
+                        const DelayInterpolation::SincTable& table)
+    {
+        constexpr int length = 1 << 16;
+        std::vector<float> x (length);
+        const double w = juce::MathConstants<double>::twoPi * freqHz / sampleRate;
+        for (int n = 0; n < length; ++n)
+            x[(size_t) n] = static_cast<float> (std::sin (w * n));
+
+        const int taps  = DelayInterpolation::numTaps (q);
+        const int first = taps / 2 - 1;
+
+        juce::Random random (1234);
+        double sigPow = 0.0, errPow = 0.0;
+
+        for (int n = taps; n < length - taps; ++n)
+        {
+            const float  frac  = random.nextFloat();
+            const float* tp    = x.data() + n - first;
+            float out = 0.0f;
+            switch (q)
+            {
+                case DelayInterpolation::Quality::Linear:   out = DelayInterpolation::linear   (tp, frac); break;
+                case DelayInterpolation::Quality::Hermite:  out = DelayInterpolation::hermite  (tp, frac); break;
+                case DelayInterpolation::Quality::Lagrange: out = DelayInterpolation::lagrange (tp, frac); break;
+                case DelayInterpolation::Quality::Sinc:     out = DelayInterpolation::sinc     (tp, frac, table); break;
+            }
+
+            const double ideal = std::sin (w * (n + static_cast<double> (frac)));
+            sigPow += ideal * ideal;
+            errPow += (out - ideal) * (out - ideal);
+        }
+
+        return 10.0 * std::log10 (errPow / sigPow);
+    }
+
+    //==========================================================================
+    // Silent input: full processing against skipSilence() once the tail has
+    // passed. Returns ns per stereo sample.
+    double timeSilence (const VibratoEngine::Params& params, bool skip, double seconds = 4.0)
+    {
+        auto engine = std::make_unique<VibratoEngine>();
+        engine->prepare (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        const int numBlocks = static_cast<int> (seconds * sampleRate) / blockSize;
+
+        double elapsed = 0.0;
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            buffer.clear();
+            const auto t0 = std::chrono::steady_clock::now();
+            if (skip)
+                engine->skipSilence (blockSize, params);
+            else
+                engine->process (buffer, params);
+            elapsed += std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+        }
+
+        return elapsed * 1.0e9 / (static_cast<double> (numBlocks) * blockSize);
+    }
+
+    //==========================================================================
+    // Many engines processed round-robin, as in a large session. Returns ns
+    // per stereo sample per engine.
+    using Session = std::vector<std::unique_ptr<VibratoEngine>>;
+
+    Session makeSession (int numEngines, bool shareTables)
+    {
+        Session engines;
+        engines.reserve (static_cast<size_t> (numEngines));
+
+        for (int e = 0; e < numEngines; ++e)
+        {
+            engines.push_back (std::make_unique<VibratoEngine>());
+            engines.back()->prepare (sampleRate, blockSize,
+                                     shareTables ? DspTables::acquire (sampleRate)
+                                                 : DspTables::build (sampleRate));
+        }
+
+        return engines;
+    }
+
+    double timeSession (Session& engines, double seconds = 1.0)
+    {
+        VibratoEngine::Params params;
+        params.triggered     = true;
+        params.onsetMs       = 10.0f;
+        params.pitchCents    = 100.0f;
+        params.formant       = 50.0f;
+        params.interpolation = DelayInterpolation::Quality::Sinc;
+
+        const int numEngines = static_cast<int> (engines.size());
+
+        juce::AudioBuffer<float> input (2, blockSize), buffer (2, blockSize);
+        juce::Random random (7);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                input.setSample (ch, i, random.nextFloat() * 0.5f - 0.25f);
+
+        // Every engine gets fresh input, as separate tracks would
+        auto run = [&] (VibratoEngine& engine)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                buffer.copyFrom (ch, 0, input, ch, 0, blockSize);
+            engine.process (buffer, params);
+        };
+
+        const int numBlocks = static_cast<int> (seconds * sampleRate) / blockSize;
+
+        for (auto& engine : engines)
+            run (*engine);
+
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int b = 0; b < numBlocks; ++b)
+            for (auto& engine : engines)
+                run (*engine);
+        const double elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+
+        return elapsed * 1.0e9 / (static_cast<double> (numBlocks) * blockSize * numEngines);
+    }
+
+    //==========================================================================
+    // Renders [from, to) of input through engine into output, skipping
+    // anything before sample 0
+    void renderRange (VibratoEngine& engine, const VibratoEngine::Params& params,
+                      const std::vector<float>& input, std::vector<float>& output,
+                      juce::int64 from, juce::int64 to)
+    {
+        juce::AudioBuffer<float> buffer (2, blockSize);
+
+        for (auto pos = from; pos < to; pos += blockSize)
+        {
+            const int n = static_cast<int> (juce::jmin<juce::int64> (blockSize, to - pos));
+            buffer.setSize (2, n, false, false, true);
+
+            for (int i = 0; i < n; ++i)
+            {
+                const auto k = pos + i;
+                const float s = k >= 0 ? input[(size_t) k] : 0.0f;
+                buffer.setSample (0, i, s);
+                buffer.setSample (1, i, s);
+            }
+
+            engine.process (buffer, params);
+
+            for (int i = 0; i < n; ++i)
+                if (pos + i >= 0)
+                    output[(size_t) (pos + i)] = buffer.getSample (0, i);
+        }
+    }
+
+    // Serial render vs. one chunk per thread, each seeked to its pre-roll
+    void benchChunkedRender (const VibratoEngine::Params& params, double seconds)
+    {
+        const auto length = static_cast<juce::int64> (seconds * sampleRate);
+        std::vector<float> input ((size_t) length), serial ((size_t) length), chunked ((size_t) length);
+
+        juce::Random random (99);
+        for (auto& s : input)
+            s = random.nextFloat() * 0.5f - 0.25f;
+
+        const std::vector<VibratoEngine::ParamEvent> timeline { { 0, params } };
+
+        auto t0 = std::chrono::steady_clock::now();
+        {
+            auto engine = std::make_unique<VibratoEngine>();
+            engine->prepare (sampleRate, blockSize);
+            renderRange (*engine, params, input, serial, 0, length);
+        }
+        const double serialTime = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+
+        const int  numThreads = juce::jmax (2, static_cast<int> (std::thread::hardware_concurrency()));
+        const auto chunkSize  = (length + numThreads - 1) / numThreads;
+
+        t0 = std::chrono::steady_clock::now();
+        {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < numThreads; ++t)
+            {
+                threads.emplace_back ([&, t]
+                {
+                    const auto start = chunkSize * t;
+                    const auto end   = juce::jmin (length, start + chunkSize);
+                    const auto from  = juce::jmax<juce::int64> (0, start - VibratoEngine::getPreRollSamples());
+
+                    auto engine = std::make_unique<VibratoEngine>();
+                    engine->prepare (sampleRate, blockSize);
+                    engine->seek (from, timeline);
+
+                    // Pre-roll writes land in the neighbouring chunk; keep
+                    // them in a scratch copy
+                    std::vector<float> scratch ((size_t) length);
+                    renderRange (*engine, params, input, scratch, from, end);
+                    std::copy (scratch.begin() + start, scratch.begin() + end, chunked.begin() + start);
+                });
+            }
+
+            for (auto& thread : threads)
+                thread.join();
+        }
+        const double chunkedTime = std::chrono::duration<double> (std::chrono::steady_clock::now() - t0).count();
+
+        float maxDiff = 0.0f;
+        for (size_t i = 0; i < serial.size(); ++i)
+            maxDiff = juce::jmax (maxDiff, std::abs (serial[i] - chunked[i]));
+
+        std::printf ("serial %8.1f ms   %d chunks %8.1f ms   speed-up %5.2fx   max diff %g\n",
+                     serialTime * 1000.0, numThreads, chunkedTime * 1000.0,
+                     serialTime / chunkedTime, static_cast<double> (maxDiff));
+    }
+}
+
+//==============================================================================
+int main()
+{
+    using Q = DelayInterpolation::Quality;
+    const Q tiers[] = { Q::Linear, Q::Hermite, Q::Lagrange, Q::Sinc };
+
+    const auto  tables = DspTables::acquire (sampleRate);
+    const auto& table  = tables->sinc;
+
+    std::printf ("Interpolation THD+N (dB, random fractional position, %.0f Hz SR)\n", sampleRate);
+    std::printf ("%-10s %10s %10s %10s %10s\n", "tier", "1 kHz", "5 kHz", "10 kHz", "15 kHz");
+    for (auto q : tiers)
+        std::printf ("%-10s %10.1f %10.1f %10.1f %10.1f\n", qualityName (q),
+                     measureThdN (q,  1000.0, table), measureThdN (q,  5000.0, table),
+                     measureThdN (q, 10000.0, table), measureThdN (q, 15000.0, table));
+
+    VibratoEngine::Params params;
+    params.triggered  = true;
+    params.onsetMs    = 10.0f;
+    params.pitchCents = 200.0f;
+    params.rateHz     = 6.0f;
+
+    std::printf ("\nEngine cost (ns per stereo sample, 200 cents)\n");
+    for (auto q : tiers)
+    {
+        params.interpolation = q;
+        std::printf ("%-10s %10.2f\n", qualityName (q), timeEngine (params));
+    }
+
+    // Latency is what each engine reports to the host (none for the delay
+    // engine); excursion is what the delay engine would need without clamping
+    std::printf ("\nPitch engines (hermite, ns per stereo sample / latency ms)\n");
+    std::printf ("%-16s %10s %10s %12s %10s %10s\n", "depth / rate", "delay ns", "delay ms",
+                 "excursion ms", "grain ns", "grain ms");
+    {
+        VibratoEngine latencyProbe;
+        latencyProbe.prepare (sampleRate, blockSize);
+        const auto ms = [] (double samples) { return samples * 1000.0 / sampleRate; };
+
+        for (auto [cents, rate] : { std::pair { 50.0f, 6.0f }, { 200.0f, 6.0f },
+                                    { 200.0f, 1.0f }, { 200.0f, 0.5f } })
+        {
+            params.interpolation = Q::Hermite;
+            params.pitchCents    = cents;
+            params.rateHz        = rate;
+
+            const double excursion = (std::exp2 (cents / 1200.0) - 1.0) * sampleRate
+                                   / (juce::MathConstants<double>::twoPi * rate);
+
+            params.pitchEngine = VibratoEngine::PitchEngine::Delay;
+            const double delayNs = timeEngine (params);
+            params.pitchEngine = VibratoEngine::PitchEngine::Grain;
+            const double grainNs = timeEngine (params);
+
+            std::printf ("%5.0f c / %4.1f Hz %10.2f %10.2f %12.2f %10.2f %10.2f\n", cents, rate,
+                         delayNs, ms (latencyProbe.getLatencySamples (VibratoEngine::PitchEngine::Delay)),
+                         ms (excursion),
+                         grainNs, ms (latencyProbe.getLatencySamples (VibratoEngine::PitchEngine::Grain)));
+        }
+    }
+
+    params.pitchEngine   = VibratoEngine::PitchEngine::Delay;
+    params.pitchCents    = 200.0f;
+    params.rateHz        = 6.0f;
+    params.interpolation = Q::Hermite;
+    params.variation     = 50.0f;
+
+    std::printf ("\nEnsemble cost (ns per stereo sample, 50%% variation)\n");
+    for (int voices : { 1, 2, 4, 8 })
+    {
+        params.voices = voices;
+        std::printf ("%d voice(s) %10.2f\n", voices, timeEngine (params));
+    }
+
+    // Heap is the live operator new bytes the prepared session adds
+    std::printf ("\nDSP tables (heap measured while the session is alive)\n");
+    std::printf ("%-8s %14s %14s %14s %14s %12s\n", "engines", "private KiB", "shared KiB",
+                 "private ns", "shared ns", "shared sets");
+    for (int n : { 1, 16, 64, 200 })
+    {
+        double heapKiB[2] = {}, ns[2] = {};
+        int    liveSets   = 0;
+
+        for (int shared = 0; shared < 2; ++shared)
+        {
+            const auto before = liveHeapBytes.load();
+            auto session = makeSession (n, shared != 0);
+            heapKiB[shared] = static_cast<double> (liveHeapBytes.load() - before) / 1024.0;
+            ns[shared]      = timeSession (session);
+
+            if (shared != 0)
+                liveSets = DspTables::getNumLiveSets();
+        }
+
+        std::printf ("%-8d %14.1f %14.1f %14.2f %14.2f %12d\n", n,
+                     heapKiB[0], heapKiB[1], ns[0], ns[1], liveSets);
+    }
+
+    std::printf ("\nSilent input (ns per stereo sample, 8 voices, 50%% variation)\n");
+    std::printf ("processed %10.2f\nskipped   %10.2f\n",
+                 timeSilence (params, false), timeSilence (params, true));
+
+    // Formant filters carry history further back than the pre-roll, so the
+    // bit-exact comparison runs without them
+    params.voices    = 3;
+    params.amplitude = 30.0f;
+
+    std::printf ("\nChunked parallel render (30 s, 3 voices, 50%% variation)\n");
+    benchChunkedRender (params, 30.0);
+
+    return 0;
+}
@@ -0,0 +1,327 @@
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+#include "../Source/PluginEditor.h"
+#include "../Source/SpriteAtlas.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+//==============================================================================
+// Headless editor benchmark: editor open time with a cold, a reopened and a
+// shared sprite atlas, and offscreen paint profiling while every knob and
+// trigger is swept. Needs no display server.
+//==============================================================================
+
+//==============================================================================
+// Allocation counting, main thread only. On glibc the C allocator's entry
+// points are interposed, so operator new (aligned forms included) and
+// juce::HeapBlock are seen through them; elsewhere only operator new is.
+namespace
+{
+    thread_local bool countAllocations = false;
+    std::atomic<juce::int64> numAllocations { 0 };
+
+    inline void noteAllocation()
+    {
+        if (countAllocations)
+            numAllocations.fetch_add (1, std::memory_order_relaxed);
+    }
+}
+
+#if defined (__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc   (size_t);
+    void* __libc_calloc   (size_t, size_t);
+    void* __libc_realloc  (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+
+    void* malloc (size_t size) noexcept             { noteAllocation(); return __libc_malloc (size); }
+    void* calloc (size_t num, size_t size) noexcept { noteAllocation(); return __libc_calloc (num, size); }
+    void* realloc (void* ptr, size_t size) noexcept { noteAllocation(); return __libc_realloc (ptr, size); }
+
+    void* memalign (size_t align, size_t size) noexcept      { noteAllocation(); return __libc_memalign (align, size); }
+    void* aligned_alloc (size_t align, size_t size) noexcept { noteAllocation(); return __libc_memalign (align, size); }
+
+    int posix_memalign (void** result, size_t align, size_t size) noexcept
+    {
+        if (align % sizeof (void*) != 0 || ! juce::isPowerOfTwo (align))
+            return EINVAL;
+
+        noteAllocation();
+        if (auto* p = __libc_memalign (align, size))
+        {
+            *result = p;
+            return 0;
+        }
+        return ENOMEM;
+    }
+}
+#else
+void* operator new (size_t size)
+{
+    noteAllocation();
+    if (auto* p = std::malloc (size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size)                 { return operator new (size); }
+void  operator delete (void* p) noexcept           { std::free (p); }
+void  operator delete[] (void* p) noexcept         { std::free (p); }
+void  operator delete (void* p, size_t) noexcept   { std::free (p); }
+void  operator delete[] (void* p, size_t) noexcept { std::free (p); }
+
+// Aligned forms keep the malloc'd base just below the returned block
+void* operator new (size_t size, std::align_val_t alignment)
+{
+    noteAllocation();
+    const auto align = juce::jmax (static_cast<size_t> (alignment), sizeof (void*));
+
+    if (auto* base = static_cast<char*> (std::malloc (size + align + sizeof (void*))))
+    {
+        const auto start = reinterpret_cast<uintptr_t> (base + sizeof (void*));
+        auto* p = reinterpret_cast<void**> ((start + align - 1) & ~static_cast<uintptr_t> (align - 1));
+        p[-1] = base;
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+static void freeAligned (void* p) noexcept
+{
+    if (p != nullptr)
+        std::free (static_cast<void**> (p)[-1]);
+}
+
+void* operator new[] (size_t size, std::align_val_t a)               { return operator new (size, a); }
+void  operator delete (void* p, std::align_val_t) noexcept           { freeAligned (p); }
+void  operator delete[] (void* p, std::align_val_t) noexcept         { freeAligned (p); }
+void  operator delete (void* p, size_t, std::align_val_t) noexcept   { freeAligned (p); }
+void  operator delete[] (void* p, size_t, std::align_val_t) noexcept { freeAligned (p); }
+#endif
+
+//==============================================================================
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr double sampleRate = 48000.0;
+    constexpr int    blockSize  = 512;
+    constexpr double frameRate  = 60.0;
+
+    double millisSince (Clock::time_point t0)
+    {
+        return std::chrono::duration<double, std::milli> (Clock::now() - t0).count();
+    }
+
+    double percentile (std::vector<double> v, double p)
+    {
+        std::sort (v.begin(), v.end());
+        const auto idx = static_cast<size_t> (p * static_cast<double> (v.size() - 1) + 0.5);
+        return v[idx];
+    }
+
+    double openEditor (TribratProcessor& processor)
+    {
+        const auto t0 = Clock::now();
+        std::unique_ptr<juce::AudioProcessorEditor> editor (processor.createEditor());
+        return millisSince (t0);
+    }
+
+    //==========================================================================
+    // Component timers, driven by simulated time instead of the message loop
+    // so label and state updates land in a known frame
+    struct SimulatedTimer
+    {
+        juce::Timer* timer;
+        double intervalMs;
+        double elapsedMs;
+    };
+
+    void collectTimers (juce::Component& c, std::vector<SimulatedTimer>& out)
+    {
+        if (auto* t = dynamic_cast<juce::Timer*> (&c))
+        {
+            if (t->isTimerRunning())
+            {
+                out.push_back ({ t, static_cast<double> (t->getTimerInterval()), 0.0 });
+                t->stopTimer();
+            }
+        }
+
+        for (auto* child : c.getChildren())
+            collectTimers (*child, out);
+    }
+
+    //==========================================================================
+    struct FrameStats
+    {
+        std::vector<double>      frameMs;
+        std::vector<juce::int64> allocations;
+    };
+
+    // Renders numFrames of the editor at a scale while sweeping all twelve
+    // knobs and toggling both triggers. The audio block feeding the scope
+    // runs outside the timed region.
+    FrameStats profilePaint (TribratProcessor& processor, float scale, int numFrames)
+    {
+        static const char* knobs[] = { "onset", "rate", "pitch", "amplitude", "formant", "variation" };
+
+        std::unique_ptr<juce::AudioProcessorEditor> editor (processor.createEditor());
+
+        std::vector<SimulatedTimer> timers;
+        collectTimers (*editor, timers);
+
+        std::vector<juce::RangedAudioParameter*> sweep, triggers;
+        for (int row = 1; row <= 2; ++row)
+        {
+            for (auto* k : knobs)
+                sweep.push_back (processor.apvts.getParameter (TribratProcessor::rowParam (row, k)));
+            triggers.push_back (processor.apvts.getParameter (TribratProcessor::rowParam (row, "trigger")));
+        }
+
+        const int samplesPerFrame = static_cast<int> (sampleRate / frameRate);
+        juce::AudioBuffer<float> audio (2, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random (3);
+
+        juce::Image image (juce::Image::ARGB,
+                           juce::roundToInt (static_cast<float> (editor->getWidth())  * scale),
+                           juce::roundToInt (static_cast<float> (editor->getHeight()) * scale),
+                           true);
+
+        FrameStats stats;
+        stats.frameMs.reserve ((size_t) numFrames);
+        stats.allocations.reserve ((size_t) numFrames);
+
+        constexpr int warmUpFrames = 30;
+
+        for (int frame = -warmUpFrames; frame < numFrames; ++frame)
+        {
+            for (int done = 0; done < samplesPerFrame; done += blockSize)
+            {
+                audio.setSize (2, juce::jmin (blockSize, samplesPerFrame - done), false, false, true);
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < audio.getNumSamples(); ++i)
+                        audio.setSample (ch, i, random.nextFloat() * 0.5f - 0.25f);
+                processor.processBlock (audio, midi);
+            }
+
+            numAllocations = 0;
+            countAllocations = true;
+            const auto t0 = Clock::now();
+
+            // Each knob sweeps end to end every two seconds, out of phase
+            const double t = (frame + warmUpFrames) / frameRate;
+            for (size_t k = 0; k < sweep.size(); ++k)
+                sweep[k]->setValueNotifyingHost (static_cast<float> (
+                    0.5 + 0.5 * std::sin (juce::MathConstants<double>::pi * t + 0.5 * static_cast<double> (k))));
+
+            if ((frame + warmUpFrames) % 30 == 0)
+                for (auto* trigger : triggers)
+                    trigger->setValueNotifyingHost (trigger->getValue() > 0.5f ? 0.0f : 1.0f);
+
+            for (auto& st : timers)
+            {
+                st.elapsedMs += 1000.0 / frameRate;
+                if (st.elapsedMs >= st.intervalMs)
+                {
+                    st.elapsedMs -= st.intervalMs;
+                    st.timer->timerCallback();
+                }
+            }
+
+            {
+                image.clear (image.getBounds());
+                juce::Graphics g (image);
+                g.addTransform (juce::AffineTransform::scale (scale));
+                editor->paintEntireComponent (g, true);
+            }
+
+            const double elapsed = millisSince (t0);
+            countAllocations = false;
+
+            if (frame >= 0)
+            {
+                stats.frameMs.push_back (elapsed);
+                stats.allocations.push_back (numAllocations.load());
+            }
+        }
+
+        return stats;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    TribratProcessor processor;
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    // First editor in the process unpacks the atlas
+    const double cold = openEditor (processor);
+
+    double atlasUnpack = 0.0;
+    {
+        const auto t0 = Clock::now();
+        SpriteAtlas atlas;
+        atlasUnpack = millisSince (t0);
+    }
+
+    // Reopening after the only editor closed unpacks the atlas again
+    constexpr int numOpens = 50;
+    std::vector<double> reopen, shared;
+    for (int i = 0; i < numOpens; ++i)
+        reopen.push_back (openEditor (processor));
+
+    // With another instance's editor open the atlas is already shared
+    {
+        TribratProcessor other;
+        other.prepareToPlay (sampleRate, blockSize);
+        std::unique_ptr<juce::AudioProcessorEditor> otherEditor (other.createEditor());
+
+        for (int i = 0; i < numOpens; ++i)
+            shared.push_back (openEditor (processor));
+    }
+
+    std::printf ("Editor open time (ms)\n");
+    std::printf ("  cold (first in process)  %8.3f\n", cold);
+    std::printf ("  atlas unpack             %8.3f\n", atlasUnpack);
+    std::printf ("  reopen        p50        %8.3f\n", percentile (reopen, 0.50));
+    std::printf ("  reopen        p95        %8.3f\n", percentile (reopen, 0.95));
+    std::printf ("  shared atlas  p50        %8.3f\n", percentile (shared, 0.50));
+    std::printf ("  shared atlas  p95        %8.3f\n", percentile (shared, 0.95));
+
+    // Paint profiling ---------------------------------------------------------
+    constexpr int numFrames = 600;
+
+    std::printf ("\nOffscreen paint, 12 knobs + 2 triggers swept (%d frames)\n", numFrames);
+    std::printf ("%-6s %9s %9s %9s %9s %12s %12s\n", "scale", "p50 ms", "p95 ms", "p99 ms",
+                 "max ms", "allocs avg", "allocs max");
+
+    for (float scale : { 1.0f, 1.5f, 2.0f })
+    {
+        const auto stats = profilePaint (processor, scale, numFrames);
+
+        juce::int64 total = 0, most = 0;
+        for (auto a : stats.allocations)
+        {
+            total += a;
+            most = juce::jmax (most, a);
+        }
+
+        std::printf ("%-6.1f %9.3f %9.3f %9.3f %9.3f %12.1f %12lld\n", static_cast<double> (scale),
+                     percentile (stats.frameMs, 0.50), percentile (stats.frameMs, 0.95),
+                     percentile (stats.frameMs, 0.99), percentile (stats.frameMs, 1.0),
+                     static_cast<double> (total) / static_cast<double> (stats.allocations.size()),
+                     static_cast<long long> (most));
+    }
+
+    return 0;
+}
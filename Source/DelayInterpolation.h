@@ -0,0 +1,156 @@
+#pragma once
+#include <cmath>
+
+//==============================================================================
+// Fractional delay-line read kernels.
+//
+// Every kernel takes a pointer to its taps laid out contiguously, oldest
+// first, so that x[numTaps / 2 - 1] is the sample at the integer read index
+// and frac (0..1) moves towards x[numTaps / 2]. The loops have fixed trip
+// counts and no branches, so the compiler can vectorise them.
+//==============================================================================
+namespace DelayInterpolation
+{
+    enum class Quality
+    {
+        Linear = 0,     // 2 taps
+        Hermite,        // 4 taps
+        Lagrange,       // 6 taps
+        Sinc            // 16 taps, polyphase windowed-sinc
+    };
+
+    constexpr int numQualities = 4;
+
+    //==========================================================================
+    // Polyphase windowed-sinc kernel table. Each phase row stores the
+    // coefficients followed by the delta to the next phase, so in-between
+    // phases are a single multiply-add per tap.
+    struct SincTable
+    {
+        static constexpr int numTaps   = 16;
+        static constexpr int numPhases = 128;
+        static constexpr int rowSize   = numTaps * 2;
+
+        alignas (64) float rows[numPhases + 1][rowSize] = {};
+
+        void build()
+        {
+            constexpr double cutoff = 0.92;     // fraction of Nyquist
+            constexpr double beta   = 8.0;      // Kaiser window shape
+            constexpr double half   = numTaps / 2;
+            constexpr double pi     = 3.14159265358979323846;
+
+            auto besselI0 = [] (double x)
+            {
+                double sum = 1.0, term = 1.0;
+                for (int k = 1; k < 32; ++k)
+                {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum  += term;
+                }
+                return sum;
+            };
+
+            double coeffs[numPhases + 1][numTaps];
+
+            for (int p = 0; p <= numPhases; ++p)
+            {
+                const double frac = static_cast<double> (p) / numPhases;
+                double sum = 0.0;
+
+                for (int k = 0; k < numTaps; ++k)
+                {
+                    const double t = static_cast<double> (k - (numTaps / 2 - 1)) - frac;
+                    const double x = pi * cutoff * t;
+                    const double s = std::abs (x) < 1.0e-9 ? 1.0 : std::sin (x) / x;
+                    const double r = t / half;
+                    const double w = std::abs (r) >= 1.0
+                                   ? 0.0
+                                   : besselI0 (beta * std::sqrt (1.0 - r * r)) / besselI0 (beta);
+                    coeffs[p][k] = s * w;
+                    sum += coeffs[p][k];
+                }
+
+                // Unity gain at DC for every phase
+                for (int k = 0; k < numTaps; ++k)
+                    coeffs[p][k] /= sum;
+            }
+
+            for (int p = 0; p <= numPhases; ++p)
+            {
+                const int next = p < numPhases ? p + 1 : p;
+                for (int k = 0; k < numTaps; ++k)
+                {
+                    rows[p][k]           = static_cast<float> (coeffs[p][k]);
+                    rows[p][numTaps + k] = static_cast<float> (coeffs[next][k] - coeffs[p][k]);
+                }
+            }
+        }
+    };
+
+    //==========================================================================
+    constexpr int maxTaps = SincTable::numTaps;
+
+    constexpr int numTaps (Quality q)
+    {
+        return q == Quality::Linear   ? 2
+             : q == Quality::Hermite  ? 4
+             : q == Quality::Lagrange ? 6
+                                      : SincTable::numTaps;
+    }
+
+    //==========================================================================
+    inline float linear (const float* x, float frac)
+    {
+        return x[0] + frac * (x[1] - x[0]);
+    }
+
+    inline float hermite (const float* x, float frac)
+    {
+        const float c0 = x[1];
+        const float c1 = 0.5f * (x[2] - x[0]);
+        const float c2 = x[0] - 2.5f * x[1] + 2.0f * x[2] - 0.5f * x[3];
+        const float c3 = 0.5f * (x[3] - x[0]) + 1.5f * (x[1] - x[2]);
+
+        return ((c3 * frac + c2) * frac + c1) * frac + c0;
+    }
+
+    inline float lagrange (const float* x, float frac)
+    {
+        // Nodes at -2 .. 3, evaluated at frac
+        const float d[6] = { frac + 2.0f, frac + 1.0f, frac,
+                             frac - 1.0f, frac - 2.0f, frac - 3.0f };
+        static constexpr float invDenom[6] = { -1.0f / 120.0f, 1.0f / 24.0f, -1.0f / 12.0f,
+                                                1.0f / 12.0f, -1.0f / 24.0f,  1.0f / 120.0f };
+
+        // Products of all node distances except the k-th, via prefix/suffix
+        float pre[6], suf[6];
+        pre[0] = 1.0f;
+        suf[5] = 1.0f;
+        for (int k = 1; k < 6; ++k)
+        {
+            pre[k]     = pre[k - 1] * d[k - 1];
+            suf[5 - k] = suf[6 - k] * d[6 - k];
+        }
+
+        float out = 0.0f;
+        for (int k = 0; k < 6; ++k)
+            out += x[k] * pre[k] * suf[k] * invDenom[k];
+        return out;
+    }
+
+    inline float sinc (const float* x, float frac, const SincTable& table)
+    {
+        const float pos   = frac * static_cast<float> (SincTable::numPhases);
+        const int   phase = static_cast<int> (pos);
+        const float t     = pos - static_cast<float> (phase);
+
+        const float* c  = table.rows[phase];
+        const float* dc = c + SincTable::numTaps;
+
+        float out = 0.0f;
+        for (int k = 0; k < SincTable::numTaps; ++k)
+            out += x[k] * (c[k] + t * dc[k]);
+        return out;
+    }
+}
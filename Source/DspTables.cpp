@@ -0,0 +1,78 @@
+#include "DspTables.h"
+#include <map>
+#include <mutex>
+
+//==============================================================================
+namespace
+{
+    // Weak references only: the engines own the tables, the registry just
+    // finds them again
+    struct Registry
+    {
+        std::mutex lock;
+        std::map<double, std::weak_ptr<const DspTables>> sets;
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // Drops the slots of sets every engine has let go of; the lock is held
+    void pruneExpired (Registry& registry)
+    {
+        for (auto it = registry.sets.begin(); it != registry.sets.end();)
+            it = it->second.expired() ? registry.sets.erase (it) : std::next (it);
+    }
+}
+
+//==============================================================================
+std::shared_ptr<const DspTables> DspTables::build (double sampleRate)
+{
+    // Plain new so the 64-byte alignment is honoured
+    std::shared_ptr<DspTables> tables (new DspTables());
+    tables->sampleRate = sampleRate;
+    tables->sinc.build();
+
+    const float maxFreq = static_cast<float> (sampleRate) * 0.48f;
+
+    for (int f = 0; f < NUM_FORMANTS; ++f)
+    {
+        for (int s = 0; s <= FORMANT_STEPS; ++s)
+        {
+            const float mult = MIN_FORMANT_MULT + (MAX_FORMANT_MULT - MIN_FORMANT_MULT)
+                             * static_cast<float> (s) / static_cast<float> (FORMANT_STEPS);
+            const float fc   = juce::jlimit (80.0f, maxFreq, formantBaseFreqs[f] * mult);
+
+            tables->formantG[f][s] = static_cast<float> (
+                std::tan (juce::MathConstants<double>::pi * fc / sampleRate));
+        }
+    }
+
+    return tables;
+}
+
+std::shared_ptr<const DspTables> DspTables::acquire (double sampleRate)
+{
+    auto& registry = getRegistry();
+    const std::lock_guard<std::mutex> sl (registry.lock);
+    pruneExpired (registry);
+
+    auto& slot = registry.sets[sampleRate];
+    if (auto existing = slot.lock())
+        return existing;
+
+    auto tables = build (sampleRate);
+    slot = tables;
+    return tables;
+}
+
+int DspTables::getNumLiveSets()
+{
+    auto& registry = getRegistry();
+    const std::lock_guard<std::mutex> sl (registry.lock);
+    pruneExpired (registry);
+
+    return static_cast<int> (registry.sets.size());
+}
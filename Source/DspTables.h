@@ -0,0 +1,57 @@
+#pragma once
+#include <JuceHeader.h>
+#include "DelayInterpolation.h"
+#include <memory>
+
+//==============================================================================
+// Read-only DSP tables shared by every VibratoEngine in the process.
+//
+// One set exists per sample rate. It is built on first use from
+// prepareToPlay(), never modified afterwards, and freed when the last engine
+// using it lets go. Every quality tier's kernels live in the same set: the
+// tier is automatable, and switching it must never build a table on the
+// audio thread.
+//==============================================================================
+struct DspTables
+{
+    static constexpr int   NUM_FORMANTS = 3;
+    static constexpr float formantBaseFreqs[NUM_FORMANTS] = { 600.0f, 1500.0f, 2800.0f };
+
+    // Formant sweep range covered by the prewarp table
+    static constexpr float MIN_FORMANT_MULT = 0.3f;
+    static constexpr float MAX_FORMANT_MULT = 1.5f;
+    static constexpr int   FORMANT_STEPS    = 256;
+
+    //==========================================================================
+    // Polyphase windowed-sinc kernel for Quality::Sinc
+    DelayInterpolation::SincTable sinc;
+
+    // SVF prewarp g = tan (pi * fc / sr) per formant over the sweep range,
+    // with the same cutoff limits SVFilter applies
+    alignas (64) float formantG[NUM_FORMANTS][FORMANT_STEPS + 1] = {};
+
+    double sampleRate = 0.0;
+
+    float getFormantG (int formant, float freqMult) const
+    {
+        const float pos = (juce::jlimit (MIN_FORMANT_MULT, MAX_FORMANT_MULT, freqMult) - MIN_FORMANT_MULT)
+                        * (static_cast<float> (FORMANT_STEPS) / (MAX_FORMANT_MULT - MIN_FORMANT_MULT));
+        const int   idx = juce::jmin (static_cast<int> (pos), FORMANT_STEPS - 1);
+        const float t   = pos - static_cast<float> (idx);
+
+        const float* g = formantG[formant];
+        return g[idx] + t * (g[idx + 1] - g[idx]);
+    }
+
+    //==========================================================================
+    // Builds a private set; engines normally go through acquire() instead
+    static std::shared_ptr<const DspTables> build (double sampleRate);
+
+    // Shared set for a sample rate, built on first request. Takes a lock, so
+    // call it from prepareToPlay(), never from the audio thread.
+    static std::shared_ptr<const DspTables> acquire (double sampleRate);
+
+    // Number of distinct shared sets currently alive (acquire() also drops
+    // the registry slots of sets that have been freed)
+    static int getNumLiveSets();
+};
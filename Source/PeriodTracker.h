@@ -0,0 +1,156 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+// Cheap YIN pitch-period tracker.
+//
+// The input is box-filtered and decimated to roughly ANALYSIS_RATE, and the
+// cumulative-mean-normalised difference function is evaluated over a short
+// window every HOP decimated samples. One lag is evaluated per decimated
+// sample, so the work is spread evenly over the hop rather than landing on
+// one push; the estimate is ready at most MAX_LAG decimated samples after
+// its window closes. All buffers are fixed-size members, so nothing
+// allocates after construction.
+//==============================================================================
+class PeriodTracker
+{
+public:
+    static constexpr double ANALYSIS_RATE = 12000.0;
+    static constexpr double MIN_FREQ_HZ   = 60.0;
+    static constexpr double MAX_FREQ_HZ   = 1000.0;
+
+    void prepare (double sampleRate)
+    {
+        decimation = juce::jmax (1, juce::roundToInt (sampleRate / ANALYSIS_RATE));
+
+        const double rate = sampleRate / decimation;
+        minLag = juce::jmax (2, static_cast<int> (rate / MAX_FREQ_HZ));
+        maxLag = juce::jmin (MAX_LAG - 1, static_cast<int> (rate / MIN_FREQ_HZ));
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill (std::begin (history), std::end (history), 0.0f);
+        writePos   = 0;
+        accum      = 0.0f;
+        accumCount = 0;
+        hopCount   = 0;
+        lag        = 0;
+        period     = 0.0f;
+    }
+
+    // Feeds one input sample; returns true when a new estimate is ready
+    bool push (float x)
+    {
+        accum += x;
+        if (++accumCount < decimation)
+            return false;
+
+        const float y = accum / static_cast<float> (decimation);
+        accum      = 0.0f;
+        accumCount = 0;
+
+        history[writePos]                = y;
+        history[writePos + HISTORY_SIZE] = y;
+        writePos = (writePos + 1) & (HISTORY_SIZE - 1);
+
+        // A new window starts once the last one is done (MAX_LAG <= HOP)
+        if (++hopCount >= HOP)
+        {
+            hopCount   = 0;
+            spanStart  = (writePos - WINDOW - maxLag) & (HISTORY_SIZE - 1);
+            lag        = 1;
+            runningSum = 0.0f;
+            bestLag    = 0;
+        }
+
+        return lag > 0 && analyseNextLag();
+    }
+
+    // Latest period in input samples, or 0 when the input is unvoiced
+    float getPeriod() const { return period; }
+
+private:
+    static constexpr int   WINDOW       = 256;
+    static constexpr int   MAX_LAG      = 256;
+    static constexpr int   HOP          = 256;       // one analysis per window
+    static constexpr int   HISTORY_SIZE = 1024;      // >= WINDOW + MAX_LAG + HOP, power-of-2
+    static constexpr float THRESHOLD    = 0.15f;
+
+    static_assert (MAX_LAG <= HOP, "an analysis must finish within its hop");
+    static_assert (HISTORY_SIZE >= WINDOW + MAX_LAG + HOP,
+                   "the span must survive the hop it is analysed over");
+
+    // Evaluates the current lag; returns true once the estimate is final
+    bool analyseNextLag()
+    {
+        // Oldest sample of the analysis span, read contiguously via the mirror
+        const float* x = history + spanStart;
+
+        // Independent partial sums so the loop vectorises without
+        // reassociation
+        float partial[8] = {};
+        for (int i = 0; i < WINDOW; i += 8)
+            for (int k = 0; k < 8; ++k)
+            {
+                const float diff = x[i + k] - x[i + k + lag];
+                partial[k] += diff * diff;
+            }
+
+        float d = 0.0f;
+        for (int k = 0; k < 8; ++k)
+            d += partial[k];
+
+        runningSum += d;
+        diffs[lag] = runningSum > 0.0f ? d * static_cast<float> (lag) / runningSum : 1.0f;
+
+        // First dip under the threshold, followed to its local minimum
+        if (lag > minLag && diffs[lag - 1] < THRESHOLD && diffs[lag] >= diffs[lag - 1])
+            bestLag = lag - 1;
+
+        if (bestLag == 0 && lag < maxLag)
+        {
+            ++lag;
+            return false;
+        }
+
+        lag = 0;
+        updatePeriod();
+        return true;
+    }
+
+    void updatePeriod()
+    {
+        if (bestLag == 0)
+        {
+            period = 0.0f;
+            return;
+        }
+
+        // Parabolic refinement around the minimum
+        const float a = diffs[bestLag - 1], b = diffs[bestLag], c = diffs[bestLag + 1];
+        const float denom = a - 2.0f * b + c;
+        const float shift = denom > 0.0f ? 0.5f * (a - c) / denom : 0.0f;
+
+        period = (static_cast<float> (bestLag) + shift) * static_cast<float> (decimation);
+    }
+
+    float history[HISTORY_SIZE * 2] = {};
+    float diffs[MAX_LAG + 1]        = {};
+
+    int   decimation = 4;
+    int   minLag     = 12;
+    int   maxLag     = 200;
+    int   writePos   = 0;
+    float accum      = 0.0f;
+    int   accumCount = 0;
+    int   hopCount   = 0;
+    float period     = 0.0f;
+
+    // Analysis in progress; lag == 0 while idle
+    int   spanStart  = 0;
+    int   lag        = 0;
+    int   bestLag    = 0;
+    float runningSum = 0.0f;
+};
@@ -1,22 +1,21 @@
 #include "PluginEditor.h"
-#include <BinaryData.h>
-
-static juce::Image loadImg (const void* data, int size)
-{
-    return juce::ImageCache::getFromMemory (data, size);
-}
 
 //==============================================================================
 //  TribratLookAndFeel
 //==============================================================================
 TribratLookAndFeel::TribratLookAndFeel()
 {
-    knobShadowImg = loadImg (BinaryData::knob_shadow_png,
-                             BinaryData::knob_shadow_pngSize);
-
     setColour (juce::Label::textColourId,       juce::Colour (0xff7a7a88));
     setColour (juce::Slider::textBoxTextColourId, juce::Colour (0xff7a7a88));
     setColour (juce::Slider::textBoxOutlineColourId, juce::Colours::transparentBlack);
+
+    setColour (juce::ComboBox::backgroundColourId, juce::Colour (0xff1a1a22));
+    setColour (juce::ComboBox::textColourId,       juce::Colour (0xff7a7a88));
+    setColour (juce::ComboBox::outlineColourId,    juce::Colour (0xff3a3a42));
+    setColour (juce::ComboBox::arrowColourId,      juce::Colour (0xff6a6a78));
+    setColour (juce::PopupMenu::backgroundColourId, juce::Colour (0xff262630));
+    setColour (juce::PopupMenu::textColourId,       juce::Colour (0xff7a7a88));
+    setColour (juce::PopupMenu::highlightedBackgroundColourId, juce::Colour (0xff4a95d5));
 }
 
 juce::Label* TribratLookAndFeel::createSliderTextBox (juce::Slider& s)
@@ -28,6 +27,11 @@ juce::Label* TribratLookAndFeel::createSliderTextBox (juce::Slider& s)
     return l;
 }
 
+juce::Font TribratLookAndFeel::getComboBoxFont (juce::ComboBox&)
+{
+    return juce::FontOptions (10.0f);
+}
+
 void TribratLookAndFeel::drawRotarySlider (juce::Graphics& g,
     int x, int y, int width, int height,
     float sliderPos, float startAngle, float endAngle,
@@ -40,13 +44,11 @@ void TribratLookAndFeel::drawRotarySlider (juce::Graphics& g,
     float cx = bounds.getCentreX();
     float cy = bounds.getCentreY();
 
-    // 1 — Shadow image behind knob
-    if (! knobShadowImg.isNull())
+    // 1 — Shadow sprite behind knob, snapped to whole pixels so it blits 1:1
     {
-        float sz = radius * 2.8f;
-        g.drawImage (knobShadowImg,
-                     { cx - sz * 0.5f, cy - sz * 0.42f, sz, sz },
-                     RectanglePlacement::stretchToFit);
+        float sz = std::round (radius * 2.8f);
+        atlas->draw (g, Sprite::knobShadow,
+                     { std::round (cx - sz * 0.5f), std::round (cy - sz * 0.42f), sz, sz });
     }
 
     // 2 — Background arc (dark track)
@@ -126,27 +128,16 @@ void TribratLookAndFeel::drawRotarySlider (juce::Graphics& g,
 ImageTriggerButton::ImageTriggerButton (juce::RangedAudioParameter& tp,
                                         juce::RangedAudioParameter& mp,
                                         int rowNumber)
-    : triggerParam (tp), modeParam (mp)
+    : triggerParam (tp), modeParam (mp),
+      onSprite  (rowNumber == 1 ? Sprite::trigger1On  : Sprite::trigger2On),
+      offSprite (rowNumber == 1 ? Sprite::trigger1Off : Sprite::trigger2Off)
 {
-    if (rowNumber == 1)
-    {
-        onImage  = loadImg (BinaryData::trigger1_on_png,  BinaryData::trigger1_on_pngSize);
-        offImage = loadImg (BinaryData::trigger1_off_png, BinaryData::trigger1_off_pngSize);
-    }
-    else
-    {
-        onImage  = loadImg (BinaryData::trigger2_on_png,  BinaryData::trigger2_on_pngSize);
-        offImage = loadImg (BinaryData::trigger2_off_png, BinaryData::trigger2_off_pngSize);
-    }
     startTimerHz (30);
 }
 
 void ImageTriggerButton::paint (juce::Graphics& g)
 {
-    auto& img = currentState ? onImage : offImage;
-    if (! img.isNull())
-        g.drawImage (img, getLocalBounds().toFloat(),
-                     juce::RectanglePlacement::centred);
+    atlas->draw (g, currentState ? onSprite : offSprite, getLocalBounds().toFloat());
 }
 
 void ImageTriggerButton::mouseDown (const juce::MouseEvent&)
@@ -179,27 +170,16 @@ void ImageTriggerButton::timerCallback()
 //  ImageToggle
 //==============================================================================
 ImageToggle::ImageToggle (juce::RangedAudioParameter& p, int rowNumber)
-    : modeParam (p)
+    : modeParam (p),
+      leftSprite  (rowNumber == 1 ? Sprite::toggle1Left  : Sprite::toggle2Left),
+      rightSprite (rowNumber == 1 ? Sprite::toggle1Right : Sprite::toggle2Right)
 {
-    if (rowNumber == 1)
-    {
-        leftImage  = loadImg (BinaryData::toggle1_left_png,  BinaryData::toggle1_left_pngSize);
-        rightImage = loadImg (BinaryData::toggle1_right_png, BinaryData::toggle1_right_pngSize);
-    }
-    else
-    {
-        leftImage  = loadImg (BinaryData::toggle2_left_png,  BinaryData::toggle2_left_pngSize);
-        rightImage = loadImg (BinaryData::toggle2_right_png, BinaryData::toggle2_right_pngSize);
-    }
     startTimerHz (30);
 }
 
 void ImageToggle::paint (juce::Graphics& g)
 {
-    auto& img = isRight ? rightImage : leftImage;
-    if (! img.isNull())
-        g.drawImage (img, getLocalBounds().toFloat(),
-                     juce::RectanglePlacement::centred);
+    atlas->draw (g, isRight ? rightSprite : leftSprite, getLocalBounds().toFloat());
 }
 
 void ImageToggle::mouseDown (const juce::MouseEvent&)
@@ -241,6 +221,31 @@ RowComponent::RowComponent (TribratProcessor& proc, int rowNumber)
     styleLabel (latchLabel,     "LATCH",     *this, 9.0f);
     styleLabel (modeLabel,      "MODE",      *this, 9.0f);
     styleLabel (triggerLabel,   "TRIGGER",   *this, 9.0f);
+    styleLabel (qualityLabel,   "QUALITY",   *this, 9.0f);
+    styleLabel (voicesLabel,    "VOICES",    *this, 9.0f);
+    styleLabel (engineLabel,    "ENGINE",    *this, 9.0f);
+
+    if (auto* q = proc.apvts.getParameter (proc.rowParam (row, "quality")))
+        qualityBox.addItemList (q->getAllValueStrings(), 1);
+    addAndMakeVisible (qualityBox);
+    qualityAttachment = std::make_unique<CA> (
+        proc.apvts, proc.rowParam (row, "quality"), qualityBox);
+
+    // AudioParameterInt has no value strings, so the items are built from its
+    // range. ComboBoxAttachment maps item index (not id) onto the normalised
+    // value, so every step of the range is listed, in order.
+    const auto voicesRange = proc.apvts.getParameterRange (proc.rowParam (row, "voices"));
+    for (int v = juce::roundToInt (voicesRange.start); v <= juce::roundToInt (voicesRange.end); ++v)
+        voicesBox.addItem (juce::String (v), v);
+    addAndMakeVisible (voicesBox);
+    voicesAttachment = std::make_unique<CA> (
+        proc.apvts, proc.rowParam (row, "voices"), voicesBox);
+
+    if (auto* e = proc.apvts.getParameter (proc.rowParam (row, "engine")))
+        engineBox.addItemList (e->getAllValueStrings(), 1);
+    addAndMakeVisible (engineBox);
+    engineAttachment = std::make_unique<CA> (
+        proc.apvts, proc.rowParam (row, "engine"), engineBox);
 
     static const char* names[]   = { "ONSET RATE", "RATE", "PITCH",
                                      "AMPLITUDE",  "FORMANT", "VARIATION" };
@@ -292,6 +297,15 @@ void RowComponent::resized()
     latchLabel.setBounds     (toggleX + toggleW + 4, toggleY + 7, 50, 16);
     modeLabel.setBounds      (toggleX, toggleY + toggleH, toggleW, 14);
 
+    // ---- Ensemble voices (top left) / pitch engine + quality (top right) ----
+    int boxW = 84, engineW = 56;
+    voicesBox.setBounds    (12, toggleY + 6, boxW, 18);
+    voicesLabel.setBounds  (12, toggleY + toggleH, boxW, 14);
+    qualityBox.setBounds   (w - boxW - 12, toggleY + 6, boxW, 18);
+    qualityLabel.setBounds (w - boxW - 12, toggleY + toggleH, boxW, 14);
+    engineBox.setBounds    (w - boxW - engineW - 16, toggleY + 6, engineW, 18);
+    engineLabel.setBounds  (w - boxW - engineW - 16, toggleY + toggleH, engineW, 14);
+
     // ---- Controls row ----
     int numCols  = 7;
     int colW     = 66;
@@ -315,12 +329,119 @@ void RowComponent::resized()
     }
 }
 
+//==============================================================================
+//  ModulationScope
+//==============================================================================
+ModulationScope::ModulationScope (TelemetryFifo& f)
+    : fifo (f)
+{
+    setOpaque (false);
+    startTimerHz (30);
+}
+
+void ModulationScope::timerCallback()
+{
+    // Meters fall ~20 dB/s; frames from both rows arrive in pairs, so the
+    // history advances once per row-2 frame
+    constexpr float meterDecay = 0.86f;
+    for (auto& t : traces)
+    {
+        t.inMeter  *= meterDecay;
+        t.outMeter *= meterDecay;
+    }
+
+    const int numFrames = fifo.drain ([this] (const TelemetryFrame& f)
+    {
+        auto& t = traces[juce::jlimit (1, 2, f.row) - 1];
+        t.modulation[writeIndex] = f.lfo * f.envelope;
+        t.envelope[writeIndex]   = f.envelope;
+        t.rateHz     = f.rateHz;
+        t.pitchCents = f.pitchCents;
+        t.inMeter    = juce::jmax (t.inMeter,  f.inPeak);
+        t.outMeter   = juce::jmax (t.outMeter, f.outPeak);
+
+        if (f.row == 2)
+            writeIndex = (writeIndex + 1) % HISTORY;
+    });
+
+    if (numFrames > 0 || traces[0].outMeter > 0.001f || traces[1].outMeter > 0.001f)
+        repaint();
+}
+
+void ModulationScope::paint (juce::Graphics& g)
+{
+    using namespace juce;
+    static const Colour rowColours[] = { Colour (0xff4a95d5), Colour (0xff6ac0b0) };
+
+    auto area = getLocalBounds().toFloat().reduced (15.0f, 4.0f);
+    g.setColour (Colour (0xff1e1e26));
+    g.fillRoundedRectangle (area, 4.0f);
+
+    auto meters = area.removeFromRight (150.0f).reduced (8.0f, 6.0f);
+    auto plot   = area.reduced (6.0f, 6.0f);
+
+    // Centre line
+    g.setColour (Colour (0xff3a3a42));
+    g.drawHorizontalLine (roundToInt (plot.getCentreY()), plot.getX(), plot.getRight());
+
+    const float dx = plot.getWidth() / static_cast<float> (HISTORY - 1);
+    const float halfH = plot.getHeight() * 0.5f;
+
+    for (int r = 0; r < 2; ++r)
+    {
+        const auto& t = traces[r];
+        Path mod, env;
+        for (int i = 0; i < HISTORY; ++i)
+        {
+            const int   idx = (writeIndex + i) % HISTORY;
+            const float x   = plot.getX() + dx * static_cast<float> (i);
+            const float ym  = plot.getCentreY() - t.modulation[idx] * halfH;
+            const float ye  = plot.getCentreY() - t.envelope[idx]   * halfH;
+            if (i == 0) { mod.startNewSubPath (x, ym); env.startNewSubPath (x, ye); }
+            else        { mod.lineTo (x, ym);          env.lineTo (x, ye); }
+        }
+
+        g.setColour (rowColours[r].withAlpha (0.35f));
+        g.strokePath (env, PathStrokeType (1.0f));
+        g.setColour (rowColours[r]);
+        g.strokePath (mod, PathStrokeType (1.5f));
+    }
+
+    // Per-row readout and input/output meters
+    g.setFont (FontOptions (9.0f));
+    const float rowH = meters.getHeight() * 0.5f;
+    for (int r = 0; r < 2; ++r)
+    {
+        const auto& t = traces[r];
+        auto line = meters.removeFromTop (rowH);
+
+        g.setColour (Colour (0xff6a6a78));
+        g.drawText (String (t.rateHz, 1) + " Hz  " + String (roundToInt (t.pitchCents)) + " c",
+                    line.removeFromTop (rowH * 0.5f), Justification::centredLeft);
+
+        auto drawMeter = [&] (Rectangle<float> bar, float peak)
+        {
+            g.setColour (Colour (0xff1a1a22));
+            g.fillRect (bar);
+            const float db   = Decibels::gainToDecibels (peak, -60.0f);
+            const float norm = jlimit (0.0f, 1.0f, (db + 60.0f) / 60.0f);
+            g.setColour (rowColours[r]);
+            g.fillRect (bar.withWidth (bar.getWidth() * norm));
+        };
+
+        auto bars = line.reduced (0.0f, 2.0f);
+        drawMeter (bars.removeFromTop (bars.getHeight() * 0.5f).reduced (0.0f, 1.0f), t.inMeter);
+        drawMeter (bars.reduced (0.0f, 1.0f), t.outMeter);
+    }
+}
+
 //==============================================================================
 //  TribratEditor
 //==============================================================================
 TribratEditor::TribratEditor (TribratProcessor& p)
     : AudioProcessorEditor (p), processor (p),
-      row1 (p, 1), row2 (p, 2)
+      row1 (p, 1), row2 (p, 2),
+      scope (p.getTelemetryFifo())
 {
     setLookAndFeel (&lnf);
 
@@ -337,14 +458,33 @@ TribratEditor::TribratEditor (TribratProcessor& p)
     footerLabel.setColour (juce::Label::textColourId, juce::Colour (0xff505058));
     addAndMakeVisible (footerLabel);
 
+    governorLabel.setJustificationType (juce::Justification::centredRight);
+    governorLabel.setFont (juce::FontOptions (9.0f));
+    governorLabel.setColour (juce::Label::textColourId, juce::Colour (0xff505058));
+    addAndMakeVisible (governorLabel);
+
+    // Per-instance CPU budget for the governor
+    budgetSlider.setSliderStyle (juce::Slider::LinearBar);
+    budgetSlider.setTextValueSuffix ("% BUDGET");
+    budgetSlider.setColour (juce::Slider::trackColourId,      juce::Colour (0x404a95d5));
+    budgetSlider.setColour (juce::Slider::backgroundColourId, juce::Colour (0xff1a1a22));
+    addAndMakeVisible (budgetSlider);
+    budgetAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
+        p.apvts, "cpuBudget", budgetSlider);
+
     addAndMakeVisible (row1);
     addAndMakeVisible (row2);
+    addAndMakeVisible (scope);
+
+    processor.setTelemetryEnabled (true);
 
-    setSize (520, 410);
+    setSize (520, 480);
+    startTimerHz (4);
 }
 
 TribratEditor::~TribratEditor()
 {
+    processor.setTelemetryEnabled (false);
     setLookAndFeel (nullptr);
 }
 
@@ -367,9 +507,26 @@ void TribratEditor::resized()
 {
     auto area = getLocalBounds();
     titleLabel.setBounds  (area.removeFromTop (38));
+    governorLabel.setBounds (titleLabel.getBounds().removeFromRight (130).reduced (12, 0));
+    budgetSlider.setBounds  (titleLabel.getBounds().removeFromLeft (130).reduced (12, 10));
     footerLabel.setBounds (area.removeFromBottom (22));
+    scope.setBounds       (area.removeFromBottom (70));
 
     int rowH = area.getHeight() / 2;
     row1.setBounds (area.removeFromTop (rowH));
     row2.setBounds (area);
 }
+
+void TribratEditor::timerCallback()
+{
+    static const char* levelNames[] = { "FULL", "REDUCED", "ECO" };
+
+    const int  load  = juce::roundToInt (processor.getCpuLoad() * 100.0f);
+    const auto state = processor.isRenderingOffline() ? juce::String ("OFFLINE")
+                     : processor.isOutputSilent()     ? juce::String ("IDLE")
+                     : juce::String (levelNames[juce::jlimit (0, 2, processor.getGovernorLevel())]);
+
+    const auto t = "CPU " + juce::String (load) + "%  " + state;
+    if (governorLabel.getText() != t)
+        governorLabel.setText (t, juce::dontSendNotification);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "PluginProcessor.h"
+#include "SpriteAtlas.h"
 
 //==============================================================================
 // Custom LookAndFeel for dark 3D knobs with blue glow arc
@@ -14,13 +15,14 @@ public:
                            juce::Slider&) override;
 
     juce::Label* createSliderTextBox (juce::Slider&) override;
+    juce::Font   getComboBoxFont (juce::ComboBox&) override;
 
 private:
-    juce::Image knobShadowImg;
+    juce::SharedResourcePointer<SpriteAtlas> atlas;
 };
 
 //==============================================================================
-// Trigger button drawn with on/off PNG images
+// Trigger button drawn with on/off atlas sprites
 //==============================================================================
 class ImageTriggerButton : public juce::Component, public juce::Timer
 {
@@ -37,12 +39,13 @@ public:
 private:
     juce::RangedAudioParameter& triggerParam;
     juce::RangedAudioParameter& modeParam;
-    juce::Image onImage, offImage;
+    juce::SharedResourcePointer<SpriteAtlas> atlas;
+    Sprite onSprite, offSprite;
     bool currentState = false;
 };
 
 //==============================================================================
-// Momentary / Latch toggle drawn with left/right PNG images
+// Momentary / Latch toggle drawn with left/right atlas sprites
 //==============================================================================
 class ImageToggle : public juce::Component, public juce::Timer
 {
@@ -55,7 +58,8 @@ public:
 
 private:
     juce::RangedAudioParameter& modeParam;
-    juce::Image leftImage, rightImage;
+    juce::SharedResourcePointer<SpriteAtlas> atlas;
+    Sprite leftSprite, rightSprite;
     bool isRight = true;
 };
 
@@ -71,6 +75,7 @@ public:
 
 private:
     using SA = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using CA = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
 
     int row;
     ImageTriggerButton triggerButton;
@@ -86,10 +91,41 @@ private:
     KnobGroup knobs[6];
     juce::Label triggerLabel;
     juce::Label momentaryLabel, latchLabel, modeLabel;
+
+    juce::ComboBox      qualityBox, voicesBox, engineBox;
+    juce::Label         qualityLabel, voicesLabel, engineLabel;
+    std::unique_ptr<CA> qualityAttachment, voicesAttachment, engineAttachment;
 };
 
 //==============================================================================
-class TribratEditor : public juce::AudioProcessorEditor
+// Live modulation scope fed from the processor's telemetry FIFO
+//==============================================================================
+class ModulationScope : public juce::Component, public juce::Timer
+{
+public:
+    explicit ModulationScope (TelemetryFifo& fifo);
+
+    void paint (juce::Graphics&) override;
+    void timerCallback() override;
+
+private:
+    static constexpr int HISTORY = 200;
+
+    struct RowTrace
+    {
+        float modulation[HISTORY] = {};     // lfo * envelope
+        float envelope[HISTORY]   = {};
+        float rateHz = 0.0f, pitchCents = 0.0f;
+        float inMeter = 0.0f, outMeter = 0.0f;
+    };
+
+    TelemetryFifo& fifo;
+    RowTrace traces[2];
+    int writeIndex = 0;
+};
+
+//==============================================================================
+class TribratEditor : public juce::AudioProcessorEditor, public juce::Timer
 {
 public:
     explicit TribratEditor (TribratProcessor&);
@@ -97,12 +133,17 @@ public:
 
     void paint   (juce::Graphics&) override;
     void resized() override;
+    void timerCallback() override;
 
 private:
     TribratProcessor&  processor;
     TribratLookAndFeel lnf;
     RowComponent       row1, row2;
-    juce::Label        titleLabel, footerLabel;
+    ModulationScope    scope;
+    juce::Label        titleLabel, footerLabel, governorLabel;
+    juce::Slider       budgetSlider;
+
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> budgetAttachment;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TribratEditor)
 };
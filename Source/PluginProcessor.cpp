@@ -48,8 +48,27 @@ TribratProcessor::createParameterLayout()
             juce::ParameterID { id ("variation"), 1 }, nm ("Variation"),
             juce::NormalisableRange<float> (0.0f, 100.0f, 0.1f),
             0.0f));
+
+        params.push_back (std::make_unique<juce::AudioParameterChoice> (
+            juce::ParameterID { id ("quality"), 1 }, nm ("Quality"),
+            juce::StringArray { "Linear", "Hermite", "Lagrange", "Sinc" }, 1));  // default = Hermite
+
+        params.push_back (std::make_unique<juce::AudioParameterInt> (
+            juce::ParameterID { id ("voices"), 1 }, nm ("Voices"), 1, VibratoEngine::MAX_VOICES, 1));
+
+        params.push_back (std::make_unique<juce::AudioParameterChoice> (
+            juce::ParameterID { id ("engine"), 1 }, nm ("Engine"),
+            juce::StringArray { "Delay", "Grain" }, 0));  // default = Delay
     }
 
+    // Share of the block period this instance may spend processing; many
+    // instances run in one callback, so the default is a few percent
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        juce::ParameterID { "cpuBudget", 1 }, "CPU Budget",
+        juce::NormalisableRange<float> (1.0f, 100.0f, 0.5f, 0.4f),
+        5.0f,
+        juce::AudioParameterFloatAttributes().withLabel ("%").withAutomatable (false)));
+
     return { params.begin(), params.end() };
 }
 
@@ -60,6 +79,27 @@ TribratProcessor::TribratProcessor()
             .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
       apvts (*this, nullptr, "Parameters", createParameterLayout())
 {
+    variationSeed = static_cast<juce::uint32> (juce::Random::getSystemRandom().nextInt());
+    apvts.state.setProperty (SEED_PROPERTY, static_cast<juce::int64> (variationSeed.load()), nullptr);
+    applyVariationSeed();
+
+    for (int r = 1; r <= 2; ++r)
+        apvts.addParameterListener (rowParam (r, "engine"), this);
+}
+
+TribratProcessor::~TribratProcessor()
+{
+    for (int r = 1; r <= 2; ++r)
+        apvts.removeParameterListener (rowParam (r, "engine"), this);
+
+    cancelPendingUpdate();
+}
+
+void TribratProcessor::applyVariationSeed()
+{
+    appliedSeed = variationSeed.load();
+    engine1.setVariationSeed (appliedSeed);
+    engine2.setVariationSeed (appliedSeed ^ 0x9e3779b9u);
 }
 
 //==============================================================================
@@ -67,10 +107,22 @@ void TribratProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     engine1.prepare (sampleRate, samplesPerBlock);
     engine2.prepare (sampleRate, samplesPerBlock);
+    applyVariationSeed();
+    updateLatency();
+    silentInputSamples = 0;
+
+    governorLevel      = 0;
+    cpuLoad            = 0.0f;
+    overBudgetSeconds  = 0.0;
+    underBudgetSeconds = 0.0;
 }
 
 void TribratProcessor::releaseResources()
 {
+    silentInputSamples   = 0;
+    lastHostPosition     = -1;
+    expectedHostPosition = -1;
+
     engine1.reset();
     engine2.reset();
 }
@@ -80,6 +132,11 @@ void TribratProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                      juce::MidiBuffer&)
 {
     juce::ScopedNoDenormals noDenormals;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    // Bounces always run at full quality
+    renderingOffline = isNonRealtime();
+    const int cpuLevel = renderingOffline.load() ? 0 : governorLevel.load();
 
     for (auto ch = getTotalNumInputChannels();
          ch < getTotalNumOutputChannels(); ++ch)
@@ -95,11 +152,236 @@ void TribratProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         out.amplitude  = apvts.getRawParameterValue (rowParam (row, "amplitude"))->load();
         out.formant    = apvts.getRawParameterValue (rowParam (row, "formant"))  ->load();
         out.variation  = apvts.getRawParameterValue (rowParam (row, "variation"))->load();
+        out.interpolation = static_cast<DelayInterpolation::Quality> (
+            juce::roundToInt (apvts.getRawParameterValue (rowParam (row, "quality"))->load()));
+        out.voices     = juce::roundToInt (apvts.getRawParameterValue (rowParam (row, "voices"))->load());
+        out.cpuLevel   = cpuLevel;
+        out.pitchEngine = static_cast<VibratoEngine::PitchEngine> (
+            juce::roundToInt (apvts.getRawParameterValue (rowParam (row, "engine"))->load()));
         return out;
     };
 
-    engine1.process (buffer, readParams (1));   // Row 1 first
-    engine2.process (buffer, readParams (2));   // Row 2 in series
+    if (variationSeed.load() != appliedSeed)
+        applyVariationSeed();
+
+    const auto params1 = readParams (1);
+    const auto params2 = readParams (2);
+
+    const int  numSamples = buffer.getNumSamples();
+
+    followHostPosition (params1, params2, numSamples);
+    const bool telemetry  = telemetryEnabled.load (std::memory_order_relaxed);
+
+    // Peaks gathered before telemetry was last switched off are stale
+    if (telemetry && ! telemetryWasEnabled)
+    {
+        telemetrySamples = 0;
+        std::fill (std::begin (telemetryPeaks), std::end (telemetryPeaks), 0.0f);
+    }
+    telemetryWasEnabled = telemetry;
+
+    auto trackPeak = [&] (int slot)
+    {
+        if (telemetry)
+            telemetryPeaks[slot] = juce::jmax (telemetryPeaks[slot],
+                                               buffer.getMagnitude (0, numSamples));
+    };
+
+    // Silence: once both rows' tails have passed, a silent block is skipped
+    // outright. Any sample above the threshold runs the whole block.
+    const bool inputSilent = buffer.getMagnitude (0, numSamples) < SILENCE_THRESHOLD;
+    const bool skip = inputSilent
+                   && silentInputSamples >= engine1.getTailSamples() + engine2.getTailSamples();
+    silentInputSamples = inputSilent ? silentInputSamples + numSamples : 0;
+
+    trackPeak (0);
+
+    if (skip)
+    {
+        buffer.clear();
+        engine1.skipSilence (numSamples, params1);
+        engine2.skipSilence (numSamples, params2);
+
+        skippedBlocks.fetch_add (1, std::memory_order_relaxed);
+        skippedSamples.fetch_add (numSamples, std::memory_order_relaxed);
+    }
+    else
+    {
+        engine1.process (buffer, params1);   // Row 1 first
+        trackPeak (1);
+        engine2.process (buffer, params2);   // Row 2 in series
+    }
+
+    trackPeak (2);
+    outputSilent = skip;
+
+    if (telemetry)
+        pushTelemetry (params1, params2, numSamples);
+
+    updateGovernor (juce::Time::getHighResolutionTicks() - startTicks,
+                    numSamples);
+}
+
+//==============================================================================
+void TribratProcessor::followHostPosition (const VibratoEngine::Params& params1,
+                                           const VibratoEngine::Params& params2,
+                                           int numSamples)
+{
+    juce::Optional<juce::int64> hostTime;
+
+    if (renderingOffline.load())
+        if (auto* playHead = getPlayHead())
+            if (auto position = playHead->getPosition())
+                if (position->getIsPlaying())
+                    hostTime = position->getTimeInSamples();
+
+    if (! hostTime.hasValue() || *hostTime < 0)
+    {
+        lastHostPosition = expectedHostPosition = -1;
+        return;
+    }
+
+    // A jump is a position that neither continues the last block nor repeats
+    // it (some hosts don't advance the playhead while rendering offline). The
+    // first playing block counts as a jump if the engines are elsewhere.
+    const auto time   = *hostTime;
+    const bool jumped = expectedHostPosition < 0 ? time != engine1.getPosition()
+                                                 : time != expectedHostPosition && time != lastHostPosition;
+
+    // Realigns the modulation to the host position, holding the current
+    // params since 0; automation before the jump is not replayed
+    if (jumped)
+    {
+        seekTimeline.front().params = params1;
+        engine1.seek (time, seekTimeline);
+        seekTimeline.front().params = params2;
+        engine2.seek (time, seekTimeline);
+    }
+
+    lastHostPosition     = time;
+    expectedHostPosition = time + numSamples;
+}
+
+//==============================================================================
+double TribratProcessor::getTailLengthSeconds() const
+{
+    const double rate = getSampleRate();
+    return rate > 0.0 ? (engine1.getTailSamples() + engine2.getTailSamples()) / rate
+                      : 0.0;
+}
+
+//==============================================================================
+void TribratProcessor::parameterChanged (const juce::String&, float)
+{
+    // May arrive on the audio thread; the host is told from the message thread
+    triggerAsyncUpdate();
+}
+
+void TribratProcessor::handleAsyncUpdate()
+{
+    updateLatency();
+}
+
+void TribratProcessor::updateLatency()
+{
+    auto engineFor = [this] (int row)
+    {
+        return static_cast<VibratoEngine::PitchEngine> (
+            juce::roundToInt (apvts.getRawParameterValue (rowParam (row, "engine"))->load()));
+    };
+
+    // Rows run in series, so their latencies add up
+    const int latency = engine1.getLatencySamples (engineFor (1))
+                      + engine2.getLatencySamples (engineFor (2));
+
+    if (latency != getLatencySamples())
+        setLatencySamples (latency);
+}
+
+void TribratProcessor::pushTelemetry (const VibratoEngine::Params& params1,
+                                      const VibratoEngine::Params& params2,
+                                      int numSamples)
+{
+    telemetrySamples += numSamples;
+    if (telemetrySamples < static_cast<int> (getSampleRate() / TELEMETRY_RATE_HZ))
+        return;
+
+    auto push = [this] (int row, const VibratoEngine& engine,
+                        const VibratoEngine::Params& params, float inPeak, float outPeak)
+    {
+        const auto t = engine.getTelemetry (params);
+
+        TelemetryFrame frame;
+        frame.row        = row;
+        frame.envelope   = t.envelope;
+        frame.lfo        = t.lfo;
+        frame.rateHz     = t.rateHz;
+        frame.pitchCents = t.pitchCents;
+        frame.inPeak     = inPeak;
+        frame.outPeak    = outPeak;
+        telemetryFifo.push (frame);
+    };
+
+    push (1, engine1, params1, telemetryPeaks[0], telemetryPeaks[1]);
+    push (2, engine2, params2, telemetryPeaks[1], telemetryPeaks[2]);
+
+    telemetrySamples = 0;
+    for (auto& peak : telemetryPeaks)
+        peak = 0.0f;
+}
+
+void TribratProcessor::updateGovernor (juce::int64 elapsedTicks, int numSamples)
+{
+    const double sampleRate = getSampleRate();
+    if (numSamples <= 0 || sampleRate <= 0.0)
+        return;
+
+    const double blockSeconds = numSamples / sampleRate;
+    const double load = juce::Time::highResolutionTicksToSeconds (elapsedTicks) / blockSeconds;
+
+    // One-pole smoothing with a ~100 ms time constant
+    const float coeff    = static_cast<float> (1.0 - std::exp (-blockSeconds / 0.1));
+    const float smoothed = cpuLoad.load() + (static_cast<float> (load) - cpuLoad.load()) * coeff;
+    cpuLoad = smoothed;
+
+    if (renderingOffline.load())
+    {
+        governorLevel      = 0;
+        overBudgetSeconds  = 0.0;
+        underBudgetSeconds = 0.0;
+        return;
+    }
+
+    const float budget = apvts.getRawParameterValue ("cpuBudget")->load() / 100.0f;
+    int level = governorLevel.load();
+
+    if (smoothed > budget)
+    {
+        underBudgetSeconds = 0.0;
+        overBudgetSeconds += blockSeconds;
+        if (overBudgetSeconds >= STEP_DOWN_SECONDS && level < MAX_GOVERNOR_LEVEL)
+        {
+            ++level;
+            overBudgetSeconds = 0.0;
+        }
+    }
+    else if (smoothed < budget * 0.5f)
+    {
+        overBudgetSeconds   = 0.0;
+        underBudgetSeconds += blockSeconds;
+        if (underBudgetSeconds >= STEP_UP_SECONDS && level > 0)
+        {
+            --level;
+            underBudgetSeconds = 0.0;
+        }
+    }
+    else
+    {
+        overBudgetSeconds  = 0.0;
+        underBudgetSeconds = 0.0;
+    }
+
+    governorLevel = level;
 }
 
 //==============================================================================
@@ -120,7 +402,16 @@ void TribratProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     std::unique_ptr<juce::XmlElement> xml (getXmlFromBinary (data, sizeInBytes));
     if (xml && xml->hasTagName (apvts.state.getType()))
+    {
         apvts.replaceState (juce::ValueTree::fromXml (*xml));
+
+        // Sessions saved before the seed was stored keep this instance's one
+        if (apvts.state.hasProperty (SEED_PROPERTY))
+            variationSeed = static_cast<juce::uint32> (
+                static_cast<juce::int64> (apvts.state.getProperty (SEED_PROPERTY)));
+        else
+            apvts.state.setProperty (SEED_PROPERTY, static_cast<juce::int64> (variationSeed.load()), nullptr);
+    }
 }
 
 //==============================================================================
@@ -1,13 +1,16 @@
 #pragma once
 #include <JuceHeader.h>
 #include "VibratoEngine.h"
+#include "Telemetry.h"
 
 //==============================================================================
-class TribratProcessor : public juce::AudioProcessor
+class TribratProcessor : public juce::AudioProcessor,
+                         private juce::AudioProcessorValueTreeState::Listener,
+                         private juce::AsyncUpdater
 {
 public:
     TribratProcessor();
-    ~TribratProcessor() override = default;
+    ~TribratProcessor() override;
 
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
@@ -20,7 +23,7 @@ public:
     bool   acceptsMidi()  const override { return false; }
     bool   producesMidi() const override { return false; }
     bool   isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override;
 
     int  getNumPrograms()    override { return 1; }
     int  getCurrentProgram() override { return 0; }
@@ -39,10 +42,105 @@ public:
         return "row" + juce::String (row) + "_" + name;
     }
 
+    // CPU governor state, safe to read from the message thread
+    int   getGovernorLevel() const   { return governorLevel.load(); }
+    float getCpuLoad() const         { return cpuLoad.load(); }
+    bool  isRenderingOffline() const { return renderingOffline.load(); }
+
+    // Silence: true while blocks are being skipped as silent in, silent out;
+    // counters run since the processor was created
+    bool        isOutputSilent() const    { return outputSilent.load(); }
+    juce::int64 getSkippedBlocks() const  { return skippedBlocks.load(); }
+    juce::int64 getSkippedSamples() const { return skippedSamples.load(); }
+
+    // Telemetry is only gathered while an editor has it switched on. Called
+    // from the FIFO's reader thread; switching on discards frames left over
+    // from the last time it was on.
+    void setTelemetryEnabled (bool shouldBeEnabled)
+    {
+        if (shouldBeEnabled)
+            telemetryFifo.discard();
+
+        telemetryEnabled = shouldBeEnabled;
+    }
+    TelemetryFifo& getTelemetryFifo()               { return telemetryFifo; }
+
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
     VibratoEngine engine1, engine2;
 
+    // Offline host seeks ------------------------------------------------------
+    //  Non-realtime renders realign the engines' modulation when the host
+    //  playhead jumps. The host doesn't hand over its automation, so the
+    //  one-entry timeline holds the current params as if they had been set
+    //  since sample 0: a jump lands on the modulation a render with those
+    //  params would have, not on what the automated session had. The
+    //  timeline is preallocated so seeking never allocates on the audio
+    //  thread.
+    void followHostPosition (const VibratoEngine::Params& params1,
+                             const VibratoEngine::Params& params2, int numSamples);
+
+    std::vector<VibratoEngine::ParamEvent> seekTimeline = std::vector<VibratoEngine::ParamEvent> (1);
+    juce::int64 lastHostPosition     = -1;
+    juce::int64 expectedHostPosition = -1;
+
+    // Variation seed ----------------------------------------------------------
+    //  Random per instance, saved with the state so a reloaded session
+    //  renders identically. Both rows' seeds derive from it; the audio
+    //  thread picks up changes at the start of a block.
+    static constexpr const char* SEED_PROPERTY = "variationSeed";
+
+    void applyVariationSeed();
+
+    std::atomic<juce::uint32> variationSeed { 0 };
+    juce::uint32              appliedSeed   = 0;
+
+    // Reports the summed latency of both rows' pitch engines to the host.
+    // Runs in prepareToPlay() and, when an engine choice changes, on the
+    // message thread via the async update.
+    void updateLatency();
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+
+    // CPU governor ------------------------------------------------------------
+    //  The load is this instance's own processing time over the block period,
+    //  and cpuBudget is its share of that period. The engines step down a
+    //  quality level when the smoothed load stays above the budget, and
+    //  back up after a longer stretch below half of it.
+    static constexpr int    MAX_GOVERNOR_LEVEL = 2;
+    static constexpr double STEP_DOWN_SECONDS  = 0.05;
+    static constexpr double STEP_UP_SECONDS    = 2.0;
+
+    void updateGovernor (juce::int64 elapsedTicks, int numSamples);
+
+    std::atomic<int>   governorLevel    { 0 };
+    std::atomic<float> cpuLoad          { 0.0f };   // share of the real-time budget
+    std::atomic<bool>  renderingOffline { false };
+    double overBudgetSeconds  = 0.0;
+    double underBudgetSeconds = 0.0;
+
+    // Silence -----------------------------------------------------------------
+    static constexpr float SILENCE_THRESHOLD = 1.0e-6f;    // -120 dBFS
+
+    juce::int64              silentInputSamples = 0;
+    std::atomic<bool>        outputSilent   { false };
+    std::atomic<juce::int64> skippedBlocks  { 0 };
+    std::atomic<juce::int64> skippedSamples { 0 };
+
+    // Telemetry ---------------------------------------------------------------
+    //  Peaks accumulate across blocks; one frame per row is pushed roughly
+    //  TELEMETRY_RATE_HZ times a second.
+    static constexpr double TELEMETRY_RATE_HZ = 200.0;
+
+    void pushTelemetry (const VibratoEngine::Params& params1,
+                        const VibratoEngine::Params& params2, int numSamples);
+
+    TelemetryFifo     telemetryFifo;
+    std::atomic<bool> telemetryEnabled { false };
+    float telemetryPeaks[3] = {};      // input, between rows, output
+    int   telemetrySamples  = 0;
+    bool  telemetryWasEnabled = false;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TribratProcessor)
 };
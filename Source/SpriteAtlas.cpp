@@ -0,0 +1,81 @@
+#include "SpriteAtlas.h"
+#include <BinaryData.h>
+
+//==============================================================================
+SpriteAtlas::SpriteAtlas()
+    : page1x (loadPage (BinaryData::sprite_atlas_1x_bin, BinaryData::sprite_atlas_1x_binSize)),
+      page2x (loadPage (BinaryData::sprite_atlas_2x_bin, BinaryData::sprite_atlas_2x_binSize))
+{
+}
+
+SpriteAtlas::Page SpriteAtlas::loadPage (const void* data, int size)
+{
+    namespace L = SpriteAtlasLayout;
+
+    Page page;
+    juce::MemoryInputStream in (data, static_cast<size_t> (size), false);
+
+    if (in.readInt() != L::magic || in.readInt() != L::version)
+    {
+        jassertfalse;   // atlas was packed by a different packer version
+        return page;
+    }
+
+    const int width      = in.readInt();
+    const int height     = in.readInt();
+    const int numSprites = in.readInt();
+
+    if (numSprites != L::numSprites || width <= 0 || height <= 0)
+    {
+        jassertfalse;
+        return page;
+    }
+
+    std::array<juce::Rectangle<int>, L::numSprites> rects;
+    for (auto& r : rects)
+    {
+        const int x = in.readInt();
+        const int y = in.readInt();
+        const int w = in.readInt();
+        const int h = in.readInt();
+        r = { x, y, w, h };
+    }
+
+    const auto lineBytes = static_cast<size_t> (width) * 4;
+    if (in.getNumBytesRemaining() < static_cast<juce::int64> (lineBytes * static_cast<size_t> (height)))
+    {
+        jassertfalse;
+        return page;
+    }
+
+    // Raw premultiplied ARGB: a straight row copy, no decoding
+    page.image = juce::Image (juce::Image::ARGB, width, height, false);
+    {
+        juce::Image::BitmapData bitmap (page.image, juce::Image::BitmapData::writeOnly);
+        const auto* pixels = static_cast<const juce::uint8*> (data) + in.getPosition();
+
+        for (int y = 0; y < height; ++y)
+            std::memcpy (bitmap.getLinePointer (y), pixels + lineBytes * static_cast<size_t> (y), lineBytes);
+    }
+
+    for (size_t i = 0; i < rects.size(); ++i)
+        page.sprites[i] = page.image.getClippedImage (rects[i]);
+
+    return page;
+}
+
+//==============================================================================
+const juce::Image& SpriteAtlas::getSprite (Sprite sprite, int scale) const
+{
+    const auto& page = scale >= 2 ? page2x : page1x;
+    return page.sprites[static_cast<size_t> (sprite)];
+}
+
+void SpriteAtlas::draw (juce::Graphics& g, Sprite sprite, juce::Rectangle<float> dest) const
+{
+    const float physicalScale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const auto& img = getSprite (sprite, physicalScale > 1.0f ? 2 : 1);
+
+    if (img.isValid())
+        g.drawImage (img, dest);
+}
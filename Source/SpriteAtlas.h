@@ -0,0 +1,35 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SpriteAtlasLayout.h"
+#include <array>
+
+//==============================================================================
+// UI artwork, pre-scaled to its on-screen size and packed into one raw atlas
+// per scale factor at build time (see Tools/AtlasPacker.cpp). Every open
+// editor shares one atlas through juce::SharedResourcePointer<SpriteAtlas>;
+// it is freed when the last editor closes and unpacked again by the next.
+//==============================================================================
+class SpriteAtlas
+{
+public:
+    SpriteAtlas();
+
+    // Draws a sprite into dest, picking the page that matches the context's
+    // physical pixel scale so the blit is 1:1 whenever dest matches the box
+    void draw (juce::Graphics&, Sprite, juce::Rectangle<float> dest) const;
+
+    const juce::Image& getSprite (Sprite, int scale = 1) const;
+
+private:
+    struct Page
+    {
+        juce::Image image;
+        std::array<juce::Image, SpriteAtlasLayout::numSprites> sprites;
+    };
+
+    static Page loadPage (const void* data, int size);
+
+    Page page1x, page2x;
+
+    JUCE_DECLARE_NON_COPYABLE (SpriteAtlas)
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+//==============================================================================
+// Sprite list and raw atlas format shared by the editor and the build-time
+// packer (Tools/AtlasPacker.cpp). Plain C++ so the packer does not need the
+// plugin's JuceHeader.
+//==============================================================================
+enum class Sprite
+{
+    trigger1Off, trigger1On,
+    trigger2Off, trigger2On,
+    toggle1Left, toggle1Right,
+    toggle2Left, toggle2Right,
+    knobShadow,
+    numSprites
+};
+
+namespace SpriteAtlasLayout
+{
+    // Source PNG and logical box. "fit" sprites are drawn centred with their
+    // aspect ratio kept, exactly as the components used to draw them; the
+    // others are stretched to the box.
+    struct Entry
+    {
+        const char* file;
+        int  width, height;
+        bool fit;
+    };
+
+    constexpr int numSprites = static_cast<int> (Sprite::numSprites);
+
+    // Must follow the Sprite order; only artwork the editor draws is packed.
+    // Boxes match RowComponent::resized() (48 px triggers, 90x30 toggles)
+    // and the knob shadow drawn for a 52 px knob in
+    // TribratLookAndFeel::drawRotarySlider().
+    constexpr Entry entries[numSprites] =
+    {
+        { "trigger1_off.png",   48, 48, true  }, { "trigger1_on.png",    48, 48, true  },
+        { "trigger2_off.png",   48, 48, true  }, { "trigger2_on.png",    48, 48, true  },
+        { "toggle1_left.png",   90, 30, true  }, { "toggle1_right.png",  90, 30, true  },
+        { "toggle2_left.png",   90, 30, true  }, { "toggle2_right.png",  90, 30, true  },
+        { "knob_shadow.png",    67, 67, false }
+    };
+
+    constexpr int scales[] = { 1, 2 };
+
+    // Raw atlas file: header, one rect per sprite, then premultiplied ARGB
+    // rows in JUCE's native pixel order. All fields are little-endian int32.
+    constexpr int magic   = 0x41425254;     // "TRBA"
+    constexpr int version = 1;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+// One decimated snapshot of a row's modulation, pushed by the audio thread.
+//==============================================================================
+struct TelemetryFrame
+{
+    int   row        = 0;
+    float envelope   = 0.0f;    // 0 - 1
+    float lfo        = 0.0f;    // -1 - 1
+    float rateHz     = 0.0f;    // effective LFO rate
+    float pitchCents = 0.0f;    // effective depth, scaled by the envelope
+    float inPeak     = 0.0f;
+    float outPeak    = 0.0f;
+};
+
+//==============================================================================
+// Single-producer / single-consumer ring of telemetry frames. push() is
+// wait-free and never allocates; frames are dropped when the reader falls
+// behind.
+//==============================================================================
+class TelemetryFifo
+{
+public:
+    static constexpr int CAPACITY = 512;
+
+    bool push (const TelemetryFrame& frame)
+    {
+        const auto scope = fifo.write (1);
+        if (scope.blockSize1 > 0)      frames[(size_t) scope.startIndex1] = frame;
+        else if (scope.blockSize2 > 0) frames[(size_t) scope.startIndex2] = frame;
+        else                           return false;
+        return true;
+    }
+
+    template <typename Callback>
+    int drain (Callback&& callback)
+    {
+        const auto scope = fifo.read (fifo.getNumReady());
+        for (int i = 0; i < scope.blockSize1; ++i) callback (frames[(size_t) (scope.startIndex1 + i)]);
+        for (int i = 0; i < scope.blockSize2; ++i) callback (frames[(size_t) (scope.startIndex2 + i)]);
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    // Reader side: drops every frame queued so far
+    void discard()
+    {
+        fifo.read (fifo.getNumReady());
+    }
+
+private:
+    juce::AbstractFifo fifo { CAPACITY };
+    std::array<TelemetryFrame, CAPACITY> frames;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+// Smooth value noise driven by a counter-based hash.
+//
+// Random knots sit on a fixed time grid and are joined with a smoothstep, so
+// the curve is a pure function of (seed, sample position): no generator
+// state, reproducible renders and identical timing at any sample rate.
+//==============================================================================
+class VariationNoise
+{
+public:
+    static constexpr double KNOT_SECONDS = 0.04;     // 40 ms between knots
+
+    void setSeed (juce::uint32 newSeed)  { seed = newSeed; }
+    juce::uint32 getSeed() const         { return seed; }
+
+    void prepare (double sampleRate)
+    {
+        knotsPerSample = 1.0 / (KNOT_SECONDS * sampleRate);
+    }
+
+    // Value in -1 .. 1 at an absolute sample position. Different streams
+    // give independent curves from the same seed.
+    float valueAt (juce::int64 samplePos, int stream = 0) const
+    {
+        const double t    = static_cast<double> (samplePos) * knotsPerSample;
+        const double knot = std::floor (t);
+        const auto   k    = static_cast<juce::uint64> (knot);
+        const float  f    = static_cast<float> (t - knot);
+        const float  s    = f * f * (3.0f - 2.0f * f);
+
+        const float a = knotValue (k,     stream);
+        const float b = knotValue (k + 1, stream);
+        return a + (b - a) * s;
+    }
+
+private:
+    // splitmix64 finaliser over (seed, stream, knot index), mapped to -1 .. 1
+    float knotValue (juce::uint64 knot, int stream) const
+    {
+        juce::uint64 z = (static_cast<juce::uint64> (seed) << 32) + knot;
+        z += static_cast<juce::uint64> (stream) * 0xd1b54a32d192ed03ull;
+        z += 0x9e3779b97f4a7c15ull;
+        z  = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z  = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+
+        return static_cast<float> (z >> 40) * (2.0f / 16777216.0f) - 1.0f;
+    }
+
+    juce::uint32 seed           = 42;
+    double       knotsPerSample = 1.0 / (KNOT_SECONDS * 44100.0);
+};
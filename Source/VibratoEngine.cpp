@@ -1,9 +1,37 @@
 #include "VibratoEngine.h"
 
+// Fixed per-voice rate offsets so ensemble voices drift against each other
+static constexpr float voiceRateScale[VibratoEngine::MAX_VOICES] =
+    { 1.0f, 0.943f, 1.061f, 0.971f, 1.037f, 0.914f, 1.089f, 1.018f };
+
 //==============================================================================
-void VibratoEngine::prepare (double sampleRate, int /*maxBlockSize*/)
+void VibratoEngine::prepare (double sampleRate, int maxBlockSize)
+{
+    prepare (sampleRate, maxBlockSize, DspTables::acquire (sampleRate));
+}
+
+void VibratoEngine::prepare (double sampleRate, int /*maxBlockSize*/,
+                             std::shared_ptr<const DspTables> tablesToUse)
 {
-    sr = sampleRate;
+    jassert (tablesToUse != nullptr && tablesToUse->sampleRate == sampleRate);
+
+    sr     = sampleRate;
+    tables = std::move (tablesToUse);
+    variationNoise.prepare (sampleRate);
+    periodTracker.prepare (sampleRate);
+
+    // The grain window has to fit the delay line with a kernel's reach to
+    // spare on both sides, which shortens it above about 200 kHz
+    grainMax       = juce::jmin (static_cast<float> (GRAIN_MAX_SECONDS * sampleRate),
+                                 static_cast<float> (DELAY_BUF_SIZE - 2 * GUARD));
+    grainNominal   = juce::jmin (static_cast<float> (GRAIN_NOMINAL_SECONDS * sampleRate),
+                                 grainMax * 0.5f);
+    grainCentre    = grainMax * 0.5f + static_cast<float> (GUARD);
+    grainSmoothing = 1.0f - std::exp (-1.0f / static_cast<float> (0.02 * sampleRate));   // 20 ms
+    voiceGlide     = 1.0f - std::exp (-1.0f / static_cast<float> (VOICE_GLIDE_SECONDS * sampleRate));
+    engineFade     = static_cast<float> (1.0 / (ENGINE_FADE_SECONDS * sampleRate));
+    jassert (grainCentre + grainMax * 0.5f <= static_cast<float> (DELAY_BUF_SIZE - GUARD));
+
     reset();
 }
 
@@ -11,156 +39,661 @@ void VibratoEngine::prepare (double sampleRate, int /*maxBlockSize*/)
 void VibratoEngine::reset()
 {
     std::memset (delayBuf, 0, sizeof (delayBuf));
-    writePos = 0;
-    lfoPhase = 0.0f;
-    envelope = 0.0f;
-    variationSmoothed  = 0.0f;
-    variationTarget    = 0.0f;
-    variationCountdown = 0;
-    formantUpdateCounter = 0;
+    snapVoiceGains();
+    resetModulation();
 
     for (int ch = 0; ch < MAX_CHANNELS; ++ch)
         for (int f = 0; f < NUM_FORMANTS; ++f)
             formantFilters[ch][f].resetState();
+
+    resetGrains();
+    grainMix = 0.0f;
+}
+
+int VibratoEngine::getLatencySamples (PitchEngine engine) const
+{
+    return engine == PitchEngine::Grain ? juce::roundToInt (grainCentre) : 0;
+}
+
+void VibratoEngine::resetModulation()
+{
+    writePos   = 0;
+    samplePos  = 0;
+    checkpoint = {};
+    segment    = {};
+    anchor     = {};
+    derived    = {};
+
+    // Spread the ensemble phases by the golden ratio
+    for (int v = 0; v < MAX_VOICES; ++v)
+        checkpoint.voicePhase[v] = std::fmod (static_cast<float> (v) * 0.618034f, 1.0f);
+
+    lfoPhase = checkpoint.lfoPhase;
+    envelope = checkpoint.envelope;
+}
+
+//==============================================================================
+void VibratoEngine::updateDerived (const Params& p)
+{
+    auto& d = derived;
+    if (d.valid && d.onsetMs == p.onsetMs && d.pitchCents == p.pitchCents
+         && d.amplitude == p.amplitude && d.formant == p.formant)
+        return;
+
+    const float fs    = static_cast<float> (sr);
+    const float twoPi = 2.0f * juce::MathConstants<float>::pi;
+
+    d.valid      = true;
+    d.onsetMs    = p.onsetMs;
+    d.pitchCents = p.pitchCents;
+    d.amplitude  = p.amplitude;
+    d.formant    = p.formant;
+
+    d.attackRate  = 1.0f / juce::jmax (1.0f, (p.onsetMs / 1000.0f) * fs);
+    d.releaseRate = 1.0f / juce::jmax (1.0f, 0.015f * fs);   // 15 ms
+    d.ampDepth    = p.amplitude / 100.0f;
+    d.fmtDepth    = p.formant   / 100.0f;
+
+    // Pitch scales without variation; with variation they follow it per
+    // sample (main voice) or per segment (ensemble voices)
+    const float pitch = juce::jmax (0.0f, p.pitchCents);
+    d.pitchDepth      = (std::exp2 (pitch / 1200.0f) - 1.0f) * fs;
+    d.voicePitchScale = d.pitchDepth / twoPi;
+}
+
+//==============================================================================
+void VibratoEngine::beginSegment (const Params& p)
+{
+    const float fs = static_cast<float> (sr);
+    Segment s;
+    s.active    = true;
+    s.length    = CONTROL_INTERVAL - static_cast<int> (checkpoint.pos & (CONTROL_INTERVAL - 1));
+    s.numVoices = juce::jlimit (1, MAX_VOICES, p.voices);
+    s.triggered = p.triggered;
+    s.onsetMs   = p.onsetMs;
+    s.rateHz    = p.rateHz;
+    s.varAmt    = p.variation / 100.0f;
+
+    // Envelope: linear ramp towards the trigger state
+    updateDerived (p);
+    s.envTarget = p.triggered ? 1.0f : 0.0f;
+    s.envStep   = checkpoint.envelope < s.envTarget ?  derived.attackRate
+                : checkpoint.envelope > s.envTarget ? -derived.releaseRate
+                                                    :  0.0f;
+
+    // Variation: linear between two points of the noise curve, so the LFO
+    // increment ramps linearly too
+    for (int v = 0; v < s.numVoices; ++v)
+    {
+        float v0 = 0.0f, dv = 0.0f;
+        if (s.varAmt > 0.0f)
+        {
+            v0 = variationNoise.valueAt (checkpoint.pos, v);
+            dv = (variationNoise.valueAt (checkpoint.pos + s.length, v) - v0)
+               / static_cast<float> (s.length);
+        }
+
+        const float rate = s.rateHz * voiceRateScale[v];
+        s.voiceVariation[v]     = v0;
+        s.voiceVariationStep[v] = dv;
+        s.voicePhaseInc[v]      = rate * (1.0f + v0 * s.varAmt * 0.25f) / fs;
+        s.voicePhaseIncStep[v]  = rate * dv * s.varAmt * 0.25f / fs;
+    }
+
+    s.variation     = s.voiceVariation[0];
+    s.variationStep = s.voiceVariationStep[0];
+    s.phaseInc      = s.voicePhaseInc[0];
+    s.phaseIncStep  = s.voicePhaseIncStep[0];
+
+    // A steady span continues while segments latch the same params
+    const bool sameLatch = s.triggered == segment.triggered && s.onsetMs == segment.onsetMs
+                        && s.rateHz == segment.rateHz && s.numVoices == segment.numVoices;
+
+    if (s.varAmt > 0.0f)
+        anchor.valid = false;
+    else if (! anchor.valid || ! sameLatch)
+        anchor = { true, s.envStep, checkpoint };
+
+    segment = s;
+}
+
+void VibratoEngine::endSegment (int length)
+{
+    segment.active = false;
+
+    if (anchor.valid)
+    {
+        advanceSteadySpan (checkpoint.pos + length);
+        return;
+    }
+
+    const int last = length - 1;
+
+    checkpoint.envelope = envelopeAt (last);
+    checkpoint.lfoPhase = phaseAt (checkpoint.lfoPhase, segment.phaseInc,
+                                   segment.phaseIncStep, last);
+
+    for (int v = 1; v < segment.numVoices; ++v)
+        checkpoint.voicePhase[v] = phaseAt (checkpoint.voicePhase[v], segment.voicePhaseInc[v],
+                                            segment.voicePhaseIncStep[v], last);
+
+    checkpoint.pos += length;
+}
+
+// Checkpoint at pos inside the anchored steady span; the phases are summed
+// in double so the result doesn't drift with the span's length
+void VibratoEngine::advanceSteadySpan (juce::int64 pos)
+{
+    const auto n = static_cast<double> (pos - anchor.state.pos);
+
+    auto phaseAfter = [n] (float phase0, float inc)
+    {
+        const double p = static_cast<double> (phase0) + static_cast<double> (inc) * n;
+        return static_cast<float> (p - std::floor (p));
+    };
+
+    const auto  target = static_cast<double> (segment.envTarget);
+    const double e     = static_cast<double> (anchor.state.envelope)
+                       + static_cast<double> (anchor.envStep) * n;
+    checkpoint.envelope = static_cast<float> (anchor.envStep > 0.0f ? juce::jmin (e, target)
+                                            : anchor.envStep < 0.0f ? juce::jmax (e, target)
+                                                                    : e);
+
+    checkpoint.lfoPhase = phaseAfter (anchor.state.lfoPhase, segment.phaseInc);
+
+    for (int v = 1; v < segment.numVoices; ++v)
+        checkpoint.voicePhase[v] = phaseAfter (anchor.state.voicePhase[v], segment.voicePhaseInc[v]);
+
+    checkpoint.pos = pos;
+}
+
+bool VibratoEngine::latchedParamsMatch (const Params& p) const
+{
+    return segment.triggered == p.triggered
+        && segment.onsetMs   == p.onsetMs
+        && segment.rateHz    == p.rateHz
+        && segment.varAmt    == p.variation / 100.0f
+        && segment.numVoices == juce::jlimit (1, MAX_VOICES, p.voices);
+}
+
+// Ends the current segment at samplePos if p changes what it latched
+void VibratoEngine::splitSegment (const Params& p)
+{
+    if (segment.active && ! latchedParamsMatch (p))
+        endSegment (static_cast<int> (samplePos - checkpoint.pos));
+}
+
+//==============================================================================
+void VibratoEngine::seek (juce::int64 targetPos, const std::vector<ParamEvent>& timeline)
+{
+    jassert (! timeline.empty() && timeline.front().samplePos <= 0);
+    resetModulation();
+
+    if (timeline.empty())
+        return;
+
+    // Replay segments up to the one containing targetPos. An event that
+    // changes the latched params ends its segment there, as the block it
+    // starts would have in a serial render.
+    size_t event = 0;
+    while (checkpoint.pos < targetPos)
+    {
+        while (event + 1 < timeline.size() && timeline[event + 1].samplePos <= checkpoint.pos)
+            ++event;
+
+        beginSegment (timeline[event].params);
+
+        // Inside a steady span every checkpoint is closed-form, so jump
+        // straight to the last boundary before the span ends
+        if (anchor.valid)
+        {
+            juce::int64 spanEnd = targetPos;
+            for (size_t e = event + 1; e < timeline.size() && timeline[e].samplePos < targetPos; ++e)
+            {
+                if (! latchedParamsMatch (timeline[e].params))
+                {
+                    spanEnd = timeline[e].samplePos;
+                    break;
+                }
+            }
+
+            const juce::int64 boundary = spanEnd & ~static_cast<juce::int64> (CONTROL_INTERVAL - 1);
+            if (boundary > checkpoint.pos + segment.length)
+            {
+                segment.active = false;
+                advanceSteadySpan (boundary);
+                continue;
+            }
+        }
+
+        juce::int64 end = checkpoint.pos + segment.length;
+        for (size_t e = event + 1; e < timeline.size() && timeline[e].samplePos < end; ++e)
+        {
+            if (! latchedParamsMatch (timeline[e].params))
+            {
+                end = timeline[e].samplePos;
+                break;
+            }
+        }
+
+        // A partial segment was latched by the serial render at its start
+        if (end > targetPos)
+            break;
+
+        endSegment (static_cast<int> (end - checkpoint.pos));
+    }
+
+    samplePos = targetPos;
+    writePos  = static_cast<int> (targetPos & (DELAY_BUF_SIZE - 1));
+
+    lfoPhase = checkpoint.lfoPhase;
+    envelope = checkpoint.envelope;
+}
+
+//==============================================================================
+int VibratoEngine::getTailSamples() const
+{
+    // A band-pass's ring decays as exp (-pi * fc * t / Q), slowest for the
+    // lowest cutoff the formant sweep reaches (the tables clamp it to 80 Hz)
+    const double lowestFc = juce::jmax (80.0, static_cast<double> (DspTables::formantBaseFreqs[0]
+                                                                 * DspTables::MIN_FORMANT_MULT));
+    const double nepers   = FILTER_TAIL_DB / 20.0 * std::log (10.0);
+    const double tailSecs = nepers * FORMANT_Q / (juce::MathConstants<double>::pi * lowestFc);
+
+    return DELAY_BUF_SIZE + static_cast<int> (std::ceil (tailSecs * sr));
+}
+
+void VibratoEngine::skipSilence (int numSamples, const Params& p)
+{
+    updateDerived (p);
+
+    // Same segment walk as process(), without the audio
+    splitSegment (p);
+
+    for (int start = 0; start < numSamples;)
+    {
+        if (! segment.active)
+            beginSegment (p);
+
+        const int offset = static_cast<int> (samplePos - checkpoint.pos);
+        const int count  = juce::jmin (segment.length - offset, numSamples - start);
+
+        samplePos += count;
+        start     += count;
+
+        if (offset + count == segment.length)
+            endSegment (segment.length);
+    }
+
+    writePos = static_cast<int> (samplePos & (DELAY_BUF_SIZE - 1));
+
+    // Last processed sample's modulation, for telemetry
+    if (segment.active)
+    {
+        const int j = static_cast<int> (samplePos - 1 - checkpoint.pos);
+        envelope = envelopeAt (j);
+        lfoPhase = phaseAt (checkpoint.lfoPhase, segment.phaseInc, segment.phaseIncStep, j);
+    }
+    else
+    {
+        envelope = checkpoint.envelope;
+        lfoPhase = checkpoint.lfoPhase;
+    }
+
+    // The decayed history is cleared once per silent stretch
+    if (! audioCleared)
+    {
+        std::memset (delayBuf, 0, sizeof (delayBuf));
+        for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+            for (int f = 0; f < NUM_FORMANTS; ++f)
+                formantFilters[ch][f].resetState();
+
+        // The grains and the tracker would otherwise resume on history
+        // that no longer exists; with nothing audible to fade, the engine
+        // switch lands at once too
+        resetGrains();
+        grainMix = p.pitchEngine == PitchEngine::Grain ? 1.0f : 0.0f;
+
+        snapVoiceGains();
+        audioCleared = true;
+    }
 }
 
 //==============================================================================
 void VibratoEngine::process (juce::AudioBuffer<float>& buffer, const Params& p)
+{
+    // Not prepared yet: the input passes through untouched
+    if (tables == nullptr)
+        return;
+
+    // CPU governor: coarser formant updates, cheaper interpolation and a
+    // control-rate LFO as the level rises
+    using Quality = DelayInterpolation::Quality;
+    const int  cpuLevel      = juce::jlimit (0, 2, p.cpuLevel);
+    const auto interpolation = cpuLevel >= 2 ? Quality::Linear
+                             : cpuLevel >= 1 ? juce::jmin (p.interpolation, Quality::Hermite)
+                                             : p.interpolation;
+
+    // The tier is dispatched once per block; each render() has its kernel
+    // inlined into the sample loop
+    switch (interpolation)
+    {
+        case Quality::Linear:   render<Quality::Linear>   (buffer, p, cpuLevel); break;
+        case Quality::Lagrange: render<Quality::Lagrange> (buffer, p, cpuLevel); break;
+        case Quality::Sinc:     render<Quality::Sinc>     (buffer, p, cpuLevel); break;
+        case Quality::Hermite:
+        default:                render<Quality::Hermite>  (buffer, p, cpuLevel); break;
+    }
+}
+
+template <DelayInterpolation::Quality Q>
+void VibratoEngine::render (juce::AudioBuffer<float>& buffer, const Params& p, int cpuLevel)
 {
     const int numSamples  = buffer.getNumSamples();
     const int numChannels = juce::jmin (buffer.getNumChannels(), MAX_CHANNELS);
-
-    // Envelope rates -----------------------------------------------------------
-    const float attackRate  = 1.0f / juce::jmax (1.0f,
-                                (p.onsetMs / 1000.0f) * static_cast<float> (sr));
-    const float releaseRate = 1.0f / juce::jmax (1.0f,
-                                0.015f * static_cast<float> (sr));   // 15 ms
-    const float envTarget   = p.triggered ? 1.0f : 0.0f;
+    const float fs        = static_cast<float> (sr);
+    const float twoPi     = 2.0f * juce::MathConstants<float>::pi;
 
     // Normalised depths --------------------------------------------------------
-    const float ampDepth = p.amplitude / 100.0f;
-    const float fmtDepth = p.formant   / 100.0f;
-    const float varAmt   = p.variation  / 100.0f;
+    updateDerived (p);
+    const float ampDepth = derived.ampDepth;
+    const float fmtDepth = derived.fmtDepth;
+
+    const int  formantInterval = CONTROL_INTERVAL << cpuLevel;
+    const bool controlRateLfo  = cpuLevel >= 2;
+
+    // Delay range the selected kernel can read without touching unwritten
+    // or overwritten samples
+    constexpr int numTaps  = DelayInterpolation::numTaps (Q);
+    const float   minDelay = static_cast<float> (numTaps / 2);
+    const float   maxDelay = static_cast<float> (DELAY_BUF_SIZE - numTaps);
 
-    // Per-sample loop ----------------------------------------------------------
-    for (int i = 0; i < numSamples; ++i)
+    const bool grainMode = p.pitchEngine == PitchEngine::Grain;
+    if (grainMode && grainMix <= 0.0f)
+        resetGrains();
+
+    const bool  grainsRunning = grainMode || grainMix > 0.0f;
+    const float mixTarget     = grainMode ? 1.0f : 0.0f;
+    audioCleared = false;
+
+    // Control segments ---------------------------------------------------------
+    //  Runs of samples up to the end of the current segment. Modulation
+    //  inside a run is computed from the segment's checkpoint; new params
+    //  cut the segment latched under the old ones short.
+    splitSegment (p);
+
+    for (int start = 0; start < numSamples;)
     {
-        // --- Envelope ---------------------------------------------------------
-        if (envelope < envTarget)
+        if (! segment.active)
+            beginSegment (p);
+
+        const int offset = static_cast<int> (samplePos - checkpoint.pos);
+        const int count  = juce::jmin (segment.length - offset, numSamples - start);
+
+        const float varAmt = segment.varAmt;
+
+        // Ensemble voices (padded to 4 lanes, delay engine only). While the
+        // gains glide every lane is read, so voices on their way out keep
+        // sounding until they reach zero.
+        const int numVoices = segment.numVoices;
+        const int panVoices = grainMode ? 1 : numVoices;
+        if (panVoices != pannedVoices || numChannels != pannedChannels)
+            updateVoicePans (panVoices, numChannels);
+
+        const bool gliding   = ! voiceGainsSettled;
+        const bool ensemble  = gliding || panVoices > 1;
+        const int  tapVoices = gliding ? MAX_VOICES : panVoices;
+        const int  numLanes  = (tapVoices + 3) & ~3;
+
+        // Extra ensemble voices: pitch scale per segment while variation
+        // moves it. Voices fading out are set too, so their depth doesn't
+        // depend on how long ago they were last active.
+        for (int v = 1; v < tapVoices; ++v)
         {
-            envelope += attackRate;
-            if (envelope > envTarget) envelope = envTarget;
+            if (varAmt > 0.0f)
+            {
+                const float effPitch = juce::jmax (0.0f, p.pitchCents
+                                         * (1.0f + segment.voiceVariation[v] * varAmt * 0.15f));
+                voicePitchScale[v] = (std::exp2 (effPitch / 1200.0f) - 1.0f)
+                                   * fs / twoPi;
+            }
+            else
+            {
+                voicePitchScale[v] = derived.voicePitchScale;
+            }
         }
-        else if (envelope > envTarget)
+
+        // Main voice mod amplitude: constant over the segment without
+        // variation, otherwise ramped between its values at the segment's ends
+        float modAmp = segment.rateHz > 0.0f
+                     ? derived.pitchDepth / (twoPi * segment.rateHz)
+                     : 0.0f;
+        float modAmpStep = 0.0f;
+
+        if (varAmt > 0.0f)
         {
-            envelope -= releaseRate;
-            if (envelope < envTarget) envelope = envTarget;
+            auto modAmpAt = [&] (float variation)
+            {
+                const float rate  = segment.rateHz * (1.0f + variation * varAmt * 0.25f);
+                const float cents = juce::jmax (0.0f, p.pitchCents * (1.0f + variation * varAmt * 0.15f));
+                return rate > 0.0f ? (std::exp2 (cents / 1200.0f) - 1.0f) * fs / (twoPi * rate)
+                                   : 0.0f;
+            };
+
+            const float length = static_cast<float> (segment.length);
+            modAmp     = modAmpAt (segment.variation);
+            modAmpStep = (modAmpAt (segment.variation + segment.variationStep * length) - modAmp) / length;
         }
 
-        // --- Variation (slowly drifting random value) -------------------------
-        if (varAmt > 0.0f)
+        // Control-rate LFO: sine (and the grain engine's cosine) at the
+        // segment's ends, linear in between
+        float lfoRamp = 0.0f, lfoRampStep = 0.0f;
+        float cosRamp = 0.0f, cosRampStep = 0.0f;
+        if (controlRateLfo)
         {
-            if (--variationCountdown <= 0)
+            const float length   = static_cast<float> (segment.length);
+            const float endPhase = phaseAt (checkpoint.lfoPhase, segment.phaseInc,
+                                            segment.phaseIncStep, segment.length - 1);
+
+            lfoRamp     = std::sin (twoPi * checkpoint.lfoPhase);
+            lfoRampStep = (std::sin (twoPi * endPhase) - lfoRamp) / length;
+
+            if (grainsRunning)
             {
-                variationTarget    = dist (rng);
-                variationCountdown = static_cast<int> (sr * 0.04f); // 40 ms
+                cosRamp     = std::cos (twoPi * checkpoint.lfoPhase);
+                cosRampStep = (std::cos (twoPi * endPhase) - cosRamp) / length;
             }
-            variationSmoothed += (variationTarget - variationSmoothed) * 0.002f;
         }
-        else
+
+        // Formant coefficients are refreshed on formantInterval boundaries
+        bool formantDue = offset == 0 && (checkpoint.pos & (formantInterval - 1)) == 0;
+
+        for (int j = offset; j < offset + count; ++j)
         {
-            variationSmoothed = 0.0f;
-        }
+            const int i = start + j - offset;
 
-        // --- LFO --------------------------------------------------------------
-        float effectiveRate = p.rateHz
-                            * (1.0f + variationSmoothed * varAmt * 0.25f);
-        effectiveRate = juce::jmax (0.01f, effectiveRate);
+            // --- Envelope -----------------------------------------------------
+            envelope = envelopeAt (j);
 
-        lfoPhase += effectiveRate / static_cast<float> (sr);
-        while (lfoPhase >= 1.0f) lfoPhase -= 1.0f;
+            // --- LFO ----------------------------------------------------------
+            const float variation = segment.variation + segment.variationStep * static_cast<float> (j);
 
-        float lfoValue = std::sin (2.0f * juce::MathConstants<float>::pi
-                                   * lfoPhase);
+            lfoPhase = phaseAt (checkpoint.lfoPhase, segment.phaseInc, segment.phaseIncStep, j);
 
-        // Variation applied to waveshape
-        float lfo = juce::jlimit (-1.0f, 1.0f,
-                        lfoValue + variationSmoothed * varAmt * 0.15f);
+            float lfoValue = controlRateLfo
+                           ? lfoRamp + lfoRampStep * static_cast<float> (j + 1)
+                           : std::sin (twoPi * lfoPhase);
 
-        // --- Delay modulation (vibrato / pitch) --------------------------------
-        float delayMod = 0.0f;
-        if (p.pitchCents > 0.0f && effectiveRate > 0.0f)
-        {
-            float effPitch = p.pitchCents
-                           * (1.0f + variationSmoothed * varAmt * 0.15f);
-            effPitch = juce::jmax (0.0f, effPitch);
-
-            float modAmp = (std::pow (2.0f, effPitch / 1200.0f) - 1.0f)
-                         * static_cast<float> (sr)
-                         / (2.0f * juce::MathConstants<float>::pi * effectiveRate);
-            delayMod = lfo * modAmp * envelope;
-        }
+            // Variation applied to waveshape
+            float lfo = juce::jlimit (-1.0f, 1.0f,
+                            lfoValue + variation * varAmt * 0.15f);
 
-        float totalDelay = BASE_DELAY + delayMod;
-        totalDelay = juce::jlimit (2.0f,
-                        static_cast<float> (DELAY_BUF_SIZE - 4), totalDelay);
+            // --- Engine crossfade ---------------------------------------------
+            if (grainMix != mixTarget)
+                grainMix = grainMode ? juce::jmin (1.0f, grainMix + engineFade)
+                                     : juce::jmax (0.0f, grainMix - engineFade);
 
-        // --- Amplitude modulation (tremolo) ------------------------------------
-        //  Swings between (1 - depth*envelope) and 1
-        float ampMod = 1.0f - ampDepth * envelope * (1.0f - lfo) * 0.5f;
+            const bool useGrains = grainMix > 0.0f;
+            const bool useDelay  = grainMix < 1.0f;
 
-        // --- Update formant filter coeffs every 32 samples --------------------
-        if (fmtDepth > 0.0f && envelope > 0.001f)
-        {
-            if (++formantUpdateCounter >= 32)
+            float delayMod = 0.0f;
+            if (useGrains)
             {
-                formantUpdateCounter = 0;
-                float depth    = fmtDepth * envelope;
-                float freqMult = 1.0f + lfo * depth * 0.4f;   // +/- 40 %
-                freqMult = juce::jmax (0.3f, freqMult);
+                // The delay engine's pitch follows the derivative of its
+                // delay, so the grains follow the LFO's cosine to match.
+                // Taps move at (1 - ratio) samples per sample.
+                const float lfoCos = controlRateLfo
+                                   ? cosRamp + cosRampStep * static_cast<float> (j + 1)
+                                   : std::cos (twoPi * lfoPhase);
+                const float effPitch = juce::jmax (0.0f, p.pitchCents
+                                         * (1.0f + variation * varAmt * 0.15f));
+                const float ratio  = std::exp2 (-lfoCos * effPitch * envelope / 1200.0f);
+                grainSize  += (grainTarget - grainSize) * grainSmoothing;
+                grainPhase += (1.0f - ratio) / grainSize;
+                grainPhase -= std::floor (grainPhase);
+            }
+
+            // --- Delay modulation (vibrato / pitch) ----------------------------
+            if (useDelay)
+                delayMod = lfo * (modAmp + modAmpStep * static_cast<float> (j)) * envelope;
 
-                for (int f = 0; f < NUM_FORMANTS; ++f)
+            float totalDelay = BASE_DELAY + delayMod;
+            totalDelay = juce::jlimit (minDelay, maxDelay, totalDelay);
+
+            // --- Amplitude modulation (tremolo) --------------------------------
+            //  Swings between (1 - depth*envelope) and 1
+            float ampMod = 1.0f - ampDepth * envelope * (1.0f - lfo) * 0.5f;
+
+            // --- Update formant filter coeffs every formantInterval samples ---
+            if (formantDue)
+            {
+                formantDue = false;
+                if (fmtDepth > 0.0f && envelope > 0.001f)
                 {
-                    float freq = formantBaseFreqs[f] * freqMult;
-                    for (int ch = 0; ch < numChannels; ++ch)
-                        formantFilters[ch][f].setParams (freq, 2.0f, sr);
+                    float depth    = fmtDepth * envelope;
+                    float freqMult = 1.0f + lfo * depth * 0.4f;   // +/- 40 %
+                    freqMult = juce::jmax (0.3f, freqMult);
+
+                    for (int f = 0; f < NUM_FORMANTS; ++f)
+                    {
+                        const float g = tables->getFormantG (f, freqMult);
+                        for (int ch = 0; ch < numChannels; ++ch)
+                            formantFilters[ch][f].setParams (g, FORMANT_Q);
+                    }
                 }
             }
-        }
 
-        // --- Per-channel processing -------------------------------------------
-        for (int ch = 0; ch < numChannels; ++ch)
-        {
-            float input = buffer.getSample (ch, i);
+            // --- Write the delay lines -----------------------------------------
+            float monoInput = 0.0f;
+
+            auto write = [this] (int line, float x)
+            {
+                delayBuf[line][writePos] = x;
+                if (writePos < GUARD)
+                    delayBuf[line][writePos + DELAY_BUF_SIZE] = x;
+            };
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const float input = buffer.getSample (ch, i);
+                monoInput += input;
+                write (ch, input);
+            }
+
+            monoInput /= static_cast<float> (juce::jmax (1, numChannels));
+            write (MID_LINE, monoInput);
+
+            // --- Extra ensemble voices ----------------------------------------
+            alignas (16) int   tapIndex[MAX_VOICES] = {};
+            alignas (16) float tapFrac[MAX_VOICES]  = {};
+            float extraVoices[MAX_CHANNELS] = {};
+
+            if (ensemble)
+            {
+                if (gliding)
+                    glideVoiceGains();
+
+                auto setTap = [&] (int v, float delay)
+                {
+                    delay = juce::jlimit (2.0f, static_cast<float> (DELAY_BUF_SIZE - 4), delay);
+                    float readPos = static_cast<float> (writePos) - delay;
+                    if (readPos < 0.0f) readPos += static_cast<float> (DELAY_BUF_SIZE);
+
+                    const int idx = static_cast<int> (readPos);
+                    tapFrac[v]  = readPos - static_cast<float> (idx);
+                    tapIndex[v] = (idx - 1) & (DELAY_BUF_SIZE - 1);
+                };
+
+                for (int v = 1; v < tapVoices; ++v)
+                {
+                    const float vVar  = segment.voiceVariation[v]
+                                      + segment.voiceVariationStep[v] * static_cast<float> (j);
+                    const float rate  = segment.rateHz * voiceRateScale[v]
+                                      * (1.0f + vVar * varAmt * 0.25f);
+                    const float phase = phaseAt (checkpoint.voicePhase[v], segment.voicePhaseInc[v],
+                                                 segment.voicePhaseIncStep[v], j);
 
-            // Write into delay line
-            delayBuf[ch][writePos] = input;
+                    const float vLfo = juce::jlimit (-1.0f, 1.0f,
+                        std::sin (twoPi * phase) + vVar * varAmt * 0.15f);
 
-            // Read from delay line (vibrato)
-            float delayed = readDelay (ch, totalDelay);
+                    setTap (v, BASE_DELAY + vLfo * voicePitchScale[v] / rate * envelope);
+                }
+
+                readEnsemble<Q> (tapIndex, tapFrac, numLanes, extraVoices);
+            }
 
-            // Formant colouring
-            float processed = delayed;
-            if (fmtDepth > 0.0f && envelope > 0.001f)
+            // --- Per-channel processing ---------------------------------------
+            for (int ch = 0; ch < numChannels; ++ch)
             {
-                float fGain = fmtDepth * envelope * 0.8f;
-                float fSum  = 0.0f;
-                for (int f = 0; f < NUM_FORMANTS; ++f)
-                    fSum += formantFilters[ch][f].processBandpass (delayed);
-                processed = delayed + fGain * fSum;
+                // Read from delay line (vibrato), blending the engines
+                // while a switch fades
+                float delayed = useDelay ? readDelay<Q> (ch, totalDelay) : 0.0f;
+                if (useGrains)
+                    delayed += grainMix * (readGrains<Q> (ch, grainPhase) - delayed);
+
+                if (ensemble)
+                    delayed = delayed * mainGain + extraVoices[ch];
+
+                // Formant colouring
+                float processed = delayed;
+                if (fmtDepth > 0.0f && envelope > 0.001f)
+                {
+                    float fGain = fmtDepth * envelope * 0.8f;
+                    float fSum  = 0.0f;
+                    for (int f = 0; f < NUM_FORMANTS; ++f)
+                        fSum += formantFilters[ch][f].processBandpass (delayed);
+                    processed = delayed + fGain * fSum;
+                }
+
+                // Tremolo
+                processed *= ampMod;
+
+                buffer.setSample (ch, i, processed);
             }
 
-            // Tremolo
-            processed *= ampMod;
+            if (useGrains && periodTracker.push (monoInput))
+                updateGrainSize();
 
-            buffer.setSample (ch, i, processed);
+            writePos = (writePos + 1) & (DELAY_BUF_SIZE - 1);
         }
 
-        writePos = (writePos + 1) & (DELAY_BUF_SIZE - 1);
+        samplePos += count;
+        start     += count;
+
+        // Gains settle on segment ends only, so where the snap lands doesn't
+        // depend on the host's block sizes
+        if (offset + count == segment.length)
+        {
+            if (gliding)
+                settleVoiceGains();
+
+            endSegment (segment.length);
+        }
     }
 }
 
 //==============================================================================
+template <DelayInterpolation::Quality Q>
 float VibratoEngine::readDelay (int channel, float delaySamples) const
 {
     float readPos = static_cast<float> (writePos) - delaySamples;
@@ -169,21 +702,193 @@ float VibratoEngine::readDelay (int channel, float delaySamples) const
     int   idx  = static_cast<int> (readPos);
     float frac = readPos - static_cast<float> (idx);
 
-    // Hermite cubic interpolation
-    int im1 = (idx - 1 + DELAY_BUF_SIZE) & (DELAY_BUF_SIZE - 1);
-    int i0  =  idx                        & (DELAY_BUF_SIZE - 1);
-    int i1  = (idx + 1)                   & (DELAY_BUF_SIZE - 1);
-    int i2  = (idx + 2)                   & (DELAY_BUF_SIZE - 1);
+    // Oldest tap; the guard region keeps the remaining taps contiguous
+    constexpr int first = DelayInterpolation::numTaps (Q) / 2 - 1;
+    const float*  taps  = delayBuf[channel] + ((idx - first) & (DELAY_BUF_SIZE - 1));
 
-    float ym1 = delayBuf[channel][im1];
-    float y0  = delayBuf[channel][i0];
-    float y1  = delayBuf[channel][i1];
-    float y2  = delayBuf[channel][i2];
+    using Quality = DelayInterpolation::Quality;
+    if constexpr (Q == Quality::Linear)        return DelayInterpolation::linear   (taps, frac);
+    else if constexpr (Q == Quality::Lagrange) return DelayInterpolation::lagrange (taps, frac);
+    else if constexpr (Q == Quality::Sinc)     return DelayInterpolation::sinc     (taps, frac, tables->sinc);
+    else                                       return DelayInterpolation::hermite  (taps, frac);
+}
 
-    float c0 = y0;
-    float c1 = 0.5f  * (y1 - ym1);
-    float c2 = ym1   - 2.5f * y0 + 2.0f * y1 - 0.5f * y2;
-    float c3 = 0.5f  * (y2 - ym1) + 1.5f * (y0 - y1);
+//==============================================================================
+void VibratoEngine::resetGrains()
+{
+    periodTracker.reset();
+    grainPhase  = 0.0f;
+    grainSize   = grainNominal;
+    grainTarget = grainNominal;
+}
+
+void VibratoEngine::updateGrainSize()
+{
+    // Whole periods closest to the nominal size that still fit the window;
+    // unvoiced input falls back to the nominal size
+    const float period = periodTracker.getPeriod();
+    if (period <= 0.0f)
+    {
+        grainTarget = grainNominal;
+        return;
+    }
+
+    float periods = juce::jmax (1.0f, std::round (grainNominal / period));
+    if (periods * period > grainMax && periods > 1.0f)
+        periods -= 1.0f;
+
+    grainTarget = juce::jmin (grainMax, periods * period);
+}
+
+template <DelayInterpolation::Quality Q>
+float VibratoEngine::readGrains (int channel, float phase) const
+{
+    // Tap B runs half a window behind tap A; the gains sum to one and are
+    // zero where each tap wraps
+    const float phaseB = phase < 0.5f ? phase + 0.5f : phase - 0.5f;
+    const float s      = std::sin (juce::MathConstants<float>::pi * phase);
+    const float gainA  = s * s;
+
+    const float delayA = grainCentre + (phase  - 0.5f) * grainSize;
+    const float delayB = grainCentre + (phaseB - 0.5f) * grainSize;
+
+    return gainA * readDelay<Q> (channel, delayA)
+         + (1.0f - gainA) * readDelay<Q> (channel, delayB);
+}
+
+//==============================================================================
+VibratoEngine::Telemetry VibratoEngine::getTelemetry (const Params& p) const
+{
+    const float varAmt    = p.variation / 100.0f;
+    const float variation = varAmt > 0.0f ? variationNoise.valueAt (samplePos) : 0.0f;
 
-    return ((c3 * frac + c2) * frac + c1) * frac + c0;
+    Telemetry t;
+    t.envelope   = envelope;
+    t.rateHz     = juce::jmax (0.01f, p.rateHz * (1.0f + variation * varAmt * 0.25f));
+    t.lfo        = juce::jlimit (-1.0f, 1.0f,
+                       std::sin (2.0f * juce::MathConstants<float>::pi * lfoPhase)
+                       + variation * varAmt * 0.15f);
+    t.pitchCents = juce::jmax (0.0f, p.pitchCents * (1.0f + variation * varAmt * 0.15f))
+                 * envelope;
+    return t;
+}
+
+//==============================================================================
+void VibratoEngine::updateVoicePans (int numVoices, int numChannels)
+{
+    pannedVoices   = numVoices;
+    pannedChannels = numChannels;
+
+    constexpr float width = 0.8f;
+    // The voices drift apart and sum close to uncorrelated, so 1 / sqrt (N)
+    // keeps the level near unity as the count changes
+    const float norm = 1.0f / std::sqrt (static_cast<float> (numVoices));
+
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+        for (int v = 0; v < MAX_VOICES; ++v)
+            voicePan[ch][v] = 0.0f;
+
+    // The main voice stays centred on its own channel
+    mainPan = norm;
+
+    for (int v = 1; v < numVoices; ++v)
+    {
+        if (numChannels < 2)
+        {
+            voicePan[0][v] = norm;
+            continue;
+        }
+
+        // Equal-power pan, the extra voices spread evenly and symmetrically
+        // around the main one
+        const int   numExtra = numVoices - 1;
+        const float pos      = numExtra < 2
+                             ? 0.0f
+                             : -1.0f + 2.0f * static_cast<float> (v - 1)
+                                            / static_cast<float> (numExtra - 1);
+        const float theta = (pos * width + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
+        voicePan[0][v] = std::cos (theta) * juce::MathConstants<float>::sqrt2 * norm;
+        voicePan[1][v] = std::sin (theta) * juce::MathConstants<float>::sqrt2 * norm;
+    }
+
+    voiceGainsSettled = mainGain == mainPan
+                     && std::equal (&voicePan[0][0], &voicePan[0][0] + MAX_CHANNELS * MAX_VOICES,
+                                    &voiceGain[0][0]);
+}
+
+void VibratoEngine::glideVoiceGains()
+{
+    mainGain += (mainPan - mainGain) * voiceGlide;
+
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+        for (int v = 0; v < MAX_VOICES; ++v)
+            voiceGain[ch][v] += (voicePan[ch][v] - voiceGain[ch][v]) * voiceGlide;
+}
+
+void VibratoEngine::settleVoiceGains()
+{
+    // Snaps to the pans once every gain is within -80 dB of its target
+    constexpr float tolerance = 1.0e-4f;
+
+    bool settled = std::abs (mainPan - mainGain) < tolerance;
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+        for (int v = 0; v < MAX_VOICES; ++v)
+            settled = settled && std::abs (voicePan[ch][v] - voiceGain[ch][v]) < tolerance;
+
+    if (settled)
+        snapVoiceGains();
+}
+
+void VibratoEngine::snapVoiceGains()
+{
+    mainGain = mainPan;
+    std::copy (&voicePan[0][0], &voicePan[0][0] + MAX_CHANNELS * MAX_VOICES, &voiceGain[0][0]);
+    voiceGainsSettled = true;
+}
+
+template <DelayInterpolation::Quality Q>
+void VibratoEngine::readEnsemble (const int* tapIndex, const float* frac,
+                                  int numLanes, float* out) const
+{
+    const float* buf = delayBuf[MID_LINE];
+
+    // Gather the four Hermite taps of every voice (structure of arrays);
+    // tapIndex points at the oldest, so the linear pair is y0, y1
+    alignas (16) float ym1[MAX_VOICES], y0[MAX_VOICES], y1[MAX_VOICES], y2[MAX_VOICES];
+    for (int v = 0; v < numLanes; ++v)
+    {
+        const float* t = buf + tapIndex[v];
+        ym1[v] = t[0];
+        y0[v]  = t[1];
+        y1[v]  = t[2];
+        y2[v]  = t[3];
+    }
+
+    // Interpolate across voices, then each channel's sum weighted by its pans
+    alignas (16) float voice[MAX_VOICES];
+    if constexpr (Q == DelayInterpolation::Quality::Linear)
+    {
+        for (int v = 0; v < numLanes; ++v)
+            voice[v] = y0[v] + frac[v] * (y1[v] - y0[v]);
+    }
+    else
+    {
+        for (int v = 0; v < numLanes; ++v)
+        {
+            const float c1 = 0.5f * (y1[v] - ym1[v]);
+            const float c2 = ym1[v] - 2.5f * y0[v] + 2.0f * y1[v] - 0.5f * y2[v];
+            const float c3 = 0.5f * (y2[v] - ym1[v]) + 1.5f * (y0[v] - y1[v]);
+            const float f  = frac[v];
+
+            voice[v] = ((c3 * f + c2) * f + c1) * f + y0[v];
+        }
+    }
+
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch)
+    {
+        float sum = 0.0f;
+        for (int v = 0; v < numLanes; ++v)
+            sum += voiceGain[ch][v] * voice[v];
+        out[ch] = sum;
+    }
 }
@@ -1,12 +1,23 @@
 #pragma once
 #include <JuceHeader.h>
+#include "DelayInterpolation.h"
+#include "DspTables.h"
+#include "PeriodTracker.h"
+#include "VariationNoise.h"
 #include <array>
-#include <random>
+#include <vector>
 #include <cmath>
 
 class VibratoEngine
 {
 public:
+    // How pitch modulation is produced
+    enum class PitchEngine
+    {
+        Delay = 0,      // modulated delay line, latency grows with depth / rate
+        Grain           // pitch-synchronous grains, small fixed latency
+    };
+
     struct Params
     {
         bool  triggered  = false;
@@ -16,12 +27,92 @@ public:
         float amplitude  = 0.0f;     // 0 - 100  (%)
         float formant    = 0.0f;     // 0 - 100  (%)
         float variation  = 0.0f;     // 0 - 100  (%)
+        DelayInterpolation::Quality interpolation = DelayInterpolation::Quality::Hermite;
+        int   voices     = 1;        // 1 - 8  (ensemble taps)
+        int   cpuLevel   = 0;        // 0 - 2  (set by the CPU governor, 0 = full quality)
+        PitchEngine pitchEngine = PitchEngine::Delay;
     };
 
+    static constexpr int MAX_VOICES = 8;
+
+    // Uses the process-wide tables for sampleRate; the overload takes a
+    // specific set instead (e.g. a private one for benchmarking)
     void prepare (double sampleRate, int maxBlockSize);
+    void prepare (double sampleRate, int maxBlockSize,
+                  std::shared_ptr<const DspTables> tablesToUse);
+
+    // Passes audio through untouched until prepare() has been called
     void process (juce::AudioBuffer<float>& buffer, const Params& params);
     void reset();
 
+    // Latency to report for the selected pitch engine, at the prepared
+    // sample rate. The delay engine's base delay is part of the effect, as
+    // it always was, so it reports none; the grain engine reports its
+    // centre delay.
+    int getLatencySamples (PitchEngine engine) const;
+
+    //==========================================================================
+    // Silence
+    //
+    // After getTailSamples() of silent input the delay line and formant
+    // filters have decayed and the output is silent too. skipSilence() then
+    // stands in for process(): it advances the modulation exactly as
+    // process() would, so the next audible block resumes at the right
+    // position, and clears the decayed audio state instead of running it.
+    // The grain engine restarts from its nominal grain, and a pending
+    // engine crossfade completes.
+    int  getTailSamples() const;
+    void skipSilence (int numSamples, const Params& params);
+
+    //==========================================================================
+    // Seeking
+    //
+    // Modulation is checkpointed on CONTROL_INTERVAL boundaries of the
+    // absolute sample position. Params that drive it (trigger, onset, rate,
+    // variation, voices) are latched when a segment starts, and everything
+    // inside a segment is a closed-form function of its checkpoint. A block
+    // whose params differ from the latched ones ends the segment early, so
+    // the change lands on the block's first sample. seek() replays only the
+    // checkpoints, splitting where the timeline changes the latched params,
+    // so it lands on exactly the state a serial render from sample 0 would
+    // have. Spans without variation are crossed in one step, so seeking
+    // costs one step per timeline event there; spans with variation are
+    // replayed segment by segment.
+    //
+    // Audio history (delay line, formant filters, grain engine) is not
+    // touched, and the grain engine's splice phase follows the tracked input,
+    // so only the delay engine renders bit-exact in chunks. Chunked
+    // renderers reset(), seek() to chunkStart - getPreRollSamples() and
+    // process the pre-roll before keeping any output.
+
+    // Params taking effect at an absolute sample position
+    struct ParamEvent
+    {
+        juce::int64 samplePos = 0;
+        Params      params;
+    };
+
+    // timeline must be sorted by samplePos and start at or before sample 0
+    void seek (juce::int64 targetPos, const std::vector<ParamEvent>& timeline);
+
+    juce::int64 getPosition() const { return samplePos; }
+
+    static constexpr int getPreRollSamples() { return DELAY_BUF_SIZE + 4096; }
+
+    // Seeds the variation curve; renders with the same seed are identical
+    void setVariationSeed (juce::uint32 seed) { variationNoise.setSeed (seed); }
+
+    // Modulation at the current position, computed on demand for the scope
+    struct Telemetry
+    {
+        float envelope   = 0.0f;
+        float lfo        = 0.0f;
+        float rateHz     = 0.0f;
+        float pitchCents = 0.0f;
+    };
+
+    Telemetry getTelemetry (const Params& params) const;
+
 private:
     //==========================================================================
     // Topology-preserving SVF – safe for per-sample modulation
@@ -30,12 +121,9 @@ private:
         float s1 = 0.f, s2 = 0.f;
         float a1 = 0.f, a2 = 0.f, a3 = 0.f;
 
-        void setParams (float cutoffHz, float Q, double sampleRate)
+        // g = tan (pi * fc / sr), looked up from DspTables
+        void setParams (float g, float Q)
         {
-            float maxFreq = static_cast<float> (sampleRate) * 0.48f;
-            float fc = juce::jlimit (80.0f, maxFreq, cutoffHz);
-            float g  = std::tan (juce::MathConstants<float>::pi * fc
-                                 / static_cast<float> (sampleRate));
             float k  = 1.0f / Q;
             a1 = 1.0f / (1.0f + g * (g + k));
             a2 = g * a1;
@@ -58,32 +146,190 @@ private:
     //==========================================================================
     double sr = 44100.0;
 
+    // Control grid -------------------------------------------------------------
+    //  Slow modulation is evaluated on CONTROL_INTERVAL boundaries of the
+    //  absolute sample position and interpolated in between. A segment cut
+    //  short by a param change is followed by one that runs to the next
+    //  boundary, so the grid itself never moves.
+    static constexpr int CONTROL_INTERVAL = 32;          // must be power-of-2
+    juce::int64 samplePos = 0;
+
+    // Modulation state at the start of the current segment
+    struct Checkpoint
+    {
+        juce::int64 pos      = 0;
+        float       envelope = 0.0f;
+        float       lfoPhase = 0.0f;
+        float       voicePhase[MAX_VOICES] = {};
+    };
+
+    // Per-segment constants, derived from the checkpoint and the latched
+    // params. Phase increments ramp linearly because variation does.
+    struct Segment
+    {
+        bool  active    = false;
+        int   length    = CONTROL_INTERVAL;   // checkpoint to the next boundary
+        int   numVoices = 1;
+        bool  triggered = false;
+        float onsetMs = 0.0f, rateHz = 0.0f, varAmt = 0.0f;
+        float envTarget = 0.0f, envStep = 0.0f;
+        float variation = 0.0f, variationStep = 0.0f;
+        float phaseInc  = 0.0f, phaseIncStep  = 0.0f;
+        alignas (16) float voiceVariation[MAX_VOICES]     = {};
+        alignas (16) float voiceVariationStep[MAX_VOICES] = {};
+        alignas (16) float voicePhaseInc[MAX_VOICES]      = {};
+        alignas (16) float voicePhaseIncStep[MAX_VOICES]  = {};
+    };
+
+    // Start of a steady span: consecutive segments with the same latched
+    // params and no variation. Checkpoints inside one are computed from the
+    // anchor in closed form, by the serial render and seek() alike.
+    struct Anchor
+    {
+        bool       valid   = false;
+        float      envStep = 0.0f;
+        Checkpoint state;
+    };
+
+    Checkpoint checkpoint;
+    Segment    segment;
+    Anchor     anchor;
+
+    // Derived params -----------------------------------------------------------
+    //  Recomputed only when the params they come from change, so steady
+    //  blocks do no transcendental math outside the LFO itself.
+    struct Derived
+    {
+        bool  valid = false;
+        float onsetMs = 0.0f, pitchCents = 0.0f, amplitude = 0.0f, formant = 0.0f;
+
+        float attackRate = 0.0f, releaseRate = 0.0f;
+        float ampDepth   = 0.0f, fmtDepth    = 0.0f;
+        float pitchDepth      = 0.0f;   // (2^(cents/1200) - 1) * sr, / (2 pi rate) = mod amplitude
+        float voicePitchScale = 0.0f;   // pitchDepth / 2 pi, / rate at the tap
+    };
+
+    Derived derived;
+
+    void updateDerived (const Params& params);
+    void resetModulation();
+    void beginSegment (const Params& params);
+    void endSegment (int length);
+    bool latchedParamsMatch (const Params& params) const;
+    void splitSegment (const Params& params);
+    void advanceSteadySpan (juce::int64 pos);
+
+    // Closed-form state j samples into the current segment (after the
+    // sample's own update, as the per-sample loop used to do it)
+    float envelopeAt (int j) const
+    {
+        const float e = checkpoint.envelope + segment.envStep * static_cast<float> (j + 1);
+        return segment.envStep > 0.0f ? juce::jmin (e, segment.envTarget)
+             : segment.envStep < 0.0f ? juce::jmax (e, segment.envTarget)
+                                      : e;
+    }
+
+    static float phaseAt (float phase0, float inc, float incStep, int j)
+    {
+        const float p = phase0 + inc * static_cast<float> (j + 1)
+                      + incStep * static_cast<float> ((j * (j + 1)) / 2);
+        return p - std::floor (p);
+    }
+
     // Delay line ---------------------------------------------------------------
+    //  The first GUARD samples are mirrored past the end so every kernel can
+    //  read its taps contiguously without wrapping. The line after the
+    //  channels holds their mono sum for the extra ensemble voices.
     static constexpr int MAX_CHANNELS   = 2;
+    static constexpr int MID_LINE       = MAX_CHANNELS;
     static constexpr int DELAY_BUF_SIZE = 4096;          // must be power-of-2
+    static constexpr int GUARD          = DelayInterpolation::maxTaps;
     static constexpr float BASE_DELAY   = 1024.0f;       // ~21 ms @ 48 kHz
-    float delayBuf[MAX_CHANNELS][DELAY_BUF_SIZE] = {};
+    float delayBuf[MAX_CHANNELS + 1][DELAY_BUF_SIZE + GUARD] = {};
     int   writePos = 0;
 
-    // LFO ----------------------------------------------------------------------
-    float lfoPhase = 0.0f;
+    std::shared_ptr<const DspTables> tables;
 
-    // Envelope -----------------------------------------------------------------
+    // LFO / envelope at the last processed sample -----------------------------
+    float lfoPhase = 0.0f;
     float envelope = 0.0f;
 
     // Variation ----------------------------------------------------------------
-    std::mt19937 rng { 42 };
-    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
-    float variationSmoothed = 0.0f;
-    float variationTarget   = 0.0f;
-    int   variationCountdown = 0;
+    VariationNoise variationNoise;
+
+    // Ensemble -----------------------------------------------------------------
+    //  Voice 0 is the main voice and reads each channel's own line, so the
+    //  input's stereo image is kept. The others are extra taps on the mono
+    //  sum line with their own LFO phase, rate offset and variation stream,
+    //  panned across the outputs, so a mono source spreads too. Gains glide
+    //  to their pans, so a voice count change (or leaving the ensemble)
+    //  doesn't click. Voice arrays are padded to a multiple of 4 lanes so
+    //  the tap reads vectorise.
+    static constexpr double VOICE_GLIDE_SECONDS = 0.01;
+
+    alignas (16) float voicePitchScale[MAX_VOICES]         = {};
+    alignas (16) float voicePan[MAX_CHANNELS][MAX_VOICES]  = {};   // targets
+    alignas (16) float voiceGain[MAX_CHANNELS][MAX_VOICES] = {};
+    float mainPan = 1.0f, mainGain = 1.0f;
+    float voiceGlide = 0.002f;
+    bool  voiceGainsSettled = true;
+    int   pannedVoices = 0, pannedChannels = 0;
+
+    void updateVoicePans (int numVoices, int numChannels);
+    void glideVoiceGains();
+    void settleVoiceGains();
+    void snapVoiceGains();
+
+    // Extra voices are read linearly when the tier is Linear (the
+    // governor's lowest level) and with Hermite otherwise
+    template <DelayInterpolation::Quality Q>
+    void readEnsemble (const int* tapIndex, const float* frac,
+                       int numLanes, float* out) const;
+
+    // Grain pitch engine -------------------------------------------------------
+    //  Two taps sweep a window of grainSize samples around a fixed centre
+    //  delay at the rate the pitch ratio asks for, crossfaded with a
+    //  constant-sum sin^2 window. The window is a whole number of tracked
+    //  periods, so the splice lands on the same point of the waveform.
+    //  Switching engines crossfades them over ENGINE_FADE_SECONDS; the grain
+    //  state restarts when a fade towards it begins from the delay engine
+    //  alone.
+    static constexpr double GRAIN_NOMINAL_SECONDS = 0.010;
+    static constexpr double GRAIN_MAX_SECONDS     = 0.020;
+    static constexpr double ENGINE_FADE_SECONDS   = 0.02;
+
+    void  resetGrains();
+    void  updateGrainSize();
+
+    template <DelayInterpolation::Quality Q>
+    float readGrains (int channel, float phase) const;
+
+    PeriodTracker periodTracker;
+    float grainPhase     = 0.0f;
+    float grainSize      = 480.0f;
+    float grainTarget    = 480.0f;
+    float grainNominal   = 480.0f;
+    float grainMax       = 960.0f;
+    float grainCentre    = 496.0f;
+    float grainSmoothing = 0.001f;
+    float grainMix       = 0.0f;       // 0 = delay engine, 1 = grain engine
+    float engineFade     = 0.001f;     // grainMix step per sample
+
+    // Silence ------------------------------------------------------------------
+    static constexpr double FILTER_TAIL_DB = 120.0;   // formant ring-out counted as decayed
+    bool audioCleared = false;
 
     // Formant filters ----------------------------------------------------------
-    static constexpr int NUM_FORMANTS = 3;
+    static constexpr int   NUM_FORMANTS = DspTables::NUM_FORMANTS;
+    static constexpr float FORMANT_Q    = 2.0f;
     SVFilter formantFilters[MAX_CHANNELS][NUM_FORMANTS];
-    float formantBaseFreqs[NUM_FORMANTS] = { 600.0f, 1500.0f, 2800.0f };
-    int   formantUpdateCounter = 0;
 
     // Helpers ------------------------------------------------------------------
+    //  The sample loop and the reads are instantiated per interpolation tier,
+    //  so process() picks the kernel once per block, not once per tap.
+    template <DelayInterpolation::Quality Q>
+    void  render (juce::AudioBuffer<float>& buffer, const Params& params, int cpuLevel);
+
+    template <DelayInterpolation::Quality Q>
     float readDelay (int channel, float delaySamples) const;
 };
@@ -0,0 +1,128 @@
+#include <juce_graphics/juce_graphics.h>
+#include "../Source/SpriteAtlasLayout.h"
+#include <array>
+#include <iostream>
+
+//==============================================================================
+// Build-time sprite packer. Decodes the UI PNGs, renders each one into its
+// on-screen box at every scale in SpriteAtlasLayout::scales and writes one
+// raw atlas per scale for juce_add_binary_data.
+//
+//   tribrato_atlas_packer <png dir> <output dir>
+//==============================================================================
+namespace
+{
+    namespace L = SpriteAtlasLayout;
+
+    constexpr int padding = 1;
+
+    bool writeAtlas (const std::array<juce::Image, L::numSprites>& sources,
+                     int scale, const juce::File& outFile)
+    {
+        // Simple shelf packing in sprite order
+        const int maxWidth = 256 * scale;
+        std::array<juce::Rectangle<int>, L::numSprites> rects;
+        int x = 0, y = 0, shelfH = 0, width = 0;
+
+        for (int i = 0; i < L::numSprites; ++i)
+        {
+            const int w = L::entries[i].width  * scale;
+            const int h = L::entries[i].height * scale;
+
+            if (x > 0 && x + w > maxWidth)
+            {
+                x = 0;
+                y += shelfH + padding;
+                shelfH = 0;
+            }
+
+            rects[(size_t) i] = { x, y, w, h };
+            x     += w + padding;
+            shelfH = juce::jmax (shelfH, h);
+            width  = juce::jmax (width, x - padding);
+        }
+
+        const int height = y + shelfH;
+
+        juce::Image atlas (juce::Image::ARGB, width, height, true, juce::SoftwareImageType());
+        {
+            juce::Graphics g (atlas);
+            g.setImageResamplingQuality (juce::Graphics::highResamplingQuality);
+
+            for (int i = 0; i < L::numSprites; ++i)
+            {
+                g.saveState();
+                g.reduceClipRegion (rects[(size_t) i]);
+                g.drawImage (sources[(size_t) i], rects[(size_t) i].toFloat(),
+                             L::entries[i].fit ? juce::RectanglePlacement::centred
+                                               : juce::RectanglePlacement::stretchToFit);
+                g.restoreState();
+            }
+        }
+
+        outFile.deleteFile();
+        juce::FileOutputStream out (outFile);
+        if (! out.openedOk())
+            return false;
+
+        out.writeInt (L::magic);
+        out.writeInt (L::version);
+        out.writeInt (width);
+        out.writeInt (height);
+        out.writeInt (L::numSprites);
+
+        for (const auto& r : rects)
+        {
+            out.writeInt (r.getX());
+            out.writeInt (r.getY());
+            out.writeInt (r.getWidth());
+            out.writeInt (r.getHeight());
+        }
+
+        const juce::Image::BitmapData bitmap (atlas, juce::Image::BitmapData::readOnly);
+        for (int row = 0; row < height; ++row)
+            out.write (bitmap.getLinePointer (row), static_cast<size_t> (width) * 4);
+
+        return out.getStatus().wasOk();
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "usage: tribrato_atlas_packer <png dir> <output dir>\n";
+        return 1;
+    }
+
+    const auto cwd    = juce::File::getCurrentWorkingDirectory();
+    const auto srcDir = cwd.getChildFile (argv[1]);
+    const auto outDir = cwd.getChildFile (argv[2]);
+    outDir.createDirectory();
+
+    std::array<juce::Image, L::numSprites> sources;
+    for (int i = 0; i < L::numSprites; ++i)
+    {
+        const auto file = srcDir.getChildFile (L::entries[i].file);
+        sources[(size_t) i] = juce::ImageFileFormat::loadFrom (file);
+
+        if (! sources[(size_t) i].isValid())
+        {
+            std::cerr << "tribrato_atlas_packer: cannot decode " << file.getFullPathName() << "\n";
+            return 1;
+        }
+    }
+
+    for (int scale : L::scales)
+    {
+        const auto outFile = outDir.getChildFile ("sprite_atlas_" + juce::String (scale) + "x.bin");
+        if (! writeAtlas (sources, scale, outFile))
+        {
+            std::cerr << "tribrato_atlas_packer: cannot write " << outFile.getFullPathName() << "\n";
+            return 1;
+        }
+    }
+
+    return 0;
+}